@@ -0,0 +1,2 @@
+gcc bench/utf8Bench.c src/utf8.c -Wall -O3 -o utf8Bench
+./utf8Bench dataset/text0.txt dataset/text1.txt dataset/text2.txt dataset/text3.txt dataset/text4.txt
\ No newline at end of file
@@ -0,0 +1,125 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../src/utf8.h"
+
+/**
+ *  \file utf8Bench.c
+ *
+ *  \brief UTF8 classification microbenchmark
+ *
+ *  Compares the table driven getUTF8CharType with the linear scan getUTF8CharTypeLinear.
+ *  Every code point of the supplied text files is decoded once and then classified repeatedly
+ *  by both functions. Before timing, both functions are checked to agree on every value up to
+ *  0xFFFFFF and on every character of the corpus.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief number of times the corpus is classified by each function */
+#define N_ITERATIONS 200
+
+/** \brief Gets the elapsed time in seconds between two instants */
+static double elapsed(struct timespec start, struct timespec end)
+{
+    return (end.tv_sec - start.tv_sec) / 1.0 + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/** \brief Reads and decodes all utf8 characters of a file
+ *
+ *  \param fileName file path
+ *  \param[in,out] chars array of decoded characters, grown as needed
+ *  \param[in,out] nChars number of decoded characters
+ *  \param[in,out] capacity capacity of the array
+ *
+ *  \returns 0 on success, -1 otherwise
+ */
+static int decodeFile(const char *fileName, unsigned int **chars, size_t *nChars, size_t *capacity)
+{
+    FILE *ptrFile = fopen(fileName, "rb");
+    if (ptrFile == NULL)
+    {
+        perror("fopen error");
+        return -1;
+    }
+
+    unsigned int utf8Char;
+    int status;
+    while ((status = readUTF8Char(ptrFile, &utf8Char)) > 0)
+    {
+        if (*nChars == *capacity)
+        {
+            *capacity = *capacity == 0 ? 4096 : *capacity * 2;
+            *chars = (unsigned int *) realloc(*chars, *capacity * sizeof(unsigned int));
+            if (*chars == NULL)
+            {
+                perror("realloc error");
+                fclose(ptrFile);
+                return -1;
+            }
+        }
+        (*chars)[(*nChars)++] = utf8Char;
+    }
+    fclose(ptrFile);
+
+    return status == 0 ? 0 : -1;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 1)
+    {
+        fprintf(stderr, "USAGE: ./utf8Bench fileName [fileName ...]\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned int *chars = NULL;
+    size_t nChars = 0, capacity = 0;
+    for (int i = 1; i < argc; i++)
+        if (decodeFile(argv[i], &chars, &nChars, &capacity) != 0)
+        {
+            fprintf(stderr, "Error decoding file %s\n", argv[i]);
+            return EXIT_FAILURE;
+        }
+
+    // both classifications must agree
+    for (unsigned int c = 0; c <= 0xFFFFFF; c++)
+        if (getUTF8CharType(c) != getUTF8CharTypeLinear(c))
+        {
+            fprintf(stderr, "Classification mismatch on 0x%X\n", c);
+            return EXIT_FAILURE;
+        }
+    for (size_t i = 0; i < nChars; i++)
+        if (getUTF8CharType(chars[i]) != getUTF8CharTypeLinear(chars[i]))
+        {
+            fprintf(stderr, "Classification mismatch on 0x%X\n", chars[i]);
+            return EXIT_FAILURE;
+        }
+
+    struct timespec startTime, endTime;
+    unsigned long histogram[NOT_DEFINED + 1] = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (int it = 0; it < N_ITERATIONS; it++)
+        for (size_t i = 0; i < nChars; i++)
+            histogram[getUTF8CharTypeLinear(chars[i])]++;
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    double linearTime = elapsed(startTime, endTime);
+
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
+    for (int it = 0; it < N_ITERATIONS; it++)
+        for (size_t i = 0; i < nChars; i++)
+            histogram[getUTF8CharType(chars[i])]++;
+    clock_gettime(CLOCK_MONOTONIC, &endTime);
+    double tableTime = elapsed(startTime, endTime);
+
+    double nClassified = (double) nChars * N_ITERATIONS;
+    printf("Characters in corpus = %zu (x%d iterations)\n", nChars, N_ITERATIONS);
+    printf("Linear scan time = %.6f s (%.2f ns/char)\n", linearTime, linearTime * 1e9 / nClassified);
+    printf("Table lookup time = %.6f s (%.2f ns/char)\n", tableTime, tableTime * 1e9 / nClassified);
+    printf("Speedup = %.2fx\n", linearTime / tableTime);
+    printf("Checksum = %lu\n", histogram[VOWEL] + histogram[CONSOANT] + histogram[DELIMITER]);
+
+    free(chars);
+    return EXIT_SUCCESS;
+}
@@ -1 +1 @@
-gcc src/countWords.c src/sharedMemory.c src/utf8.c -lpthread -Wall -O3 -o countWords
\ No newline at end of file
+gcc src/countWords.c src/sharedMemory.c src/utf8.c src/wordScanner.c src/prefetchReader.c -lpthread -Wall -O3 -o countWords
\ No newline at end of file
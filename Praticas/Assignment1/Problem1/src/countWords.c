@@ -3,9 +3,12 @@
 #include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
+#include <unistd.h>
 #include "sharedMemory.h"
 #include "utf8.h"
+#include "wordScanner.h"
 #include "probConst.h"
+#include "prefetchReader.h"
 
 /**
  *  \file countWords.c
@@ -29,9 +32,15 @@ static void * work(void *args);
 /** \brief Print results. */
 void printResults(const Results results);
 
+/** \brief Print command line usage. */
+static void printUsage();
+
 
 /** \brief worker threads return status array */
-int statusWorkers[N];
+int *statusWorkers;
+
+/** \brief source of the chunks of data given to the workers */
+static enum ChunkSource chunkSource = READ_SOURCE;
 
 /** \brief Main thread.
  *  
@@ -41,39 +50,110 @@ int statusWorkers[N];
 */
 int main(int argc, char *argv[])
 {
+    //Parse options
+    int nWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int chunkSize = DATA_BUFFER_SIZE;
+    unsigned int prefetchDepth = PREFETCH_DEPTH;
+    int opt;
+    while ((opt = getopt(argc, argv, "t:c:map:sh")) != -1)
+    {
+        switch (opt)
+        {
+        case 't':
+            nWorkers = atoi(optarg);
+            if (nWorkers < 1)
+            {
+                fprintf(stderr, "Invalid number of worker threads: %s\n", optarg);
+                return 1;
+            }
+            break;
+
+        case 'c':
+            if (strcmp(optarg, "auto") == 0)
+                chunkSize = 0;
+            else if (atol(optarg) < MIN_DATA_BUFFER_SIZE)
+            {
+                fprintf(stderr, "Invalid chunk size: %s (minimum %d bytes)\n", optarg, MIN_DATA_BUFFER_SIZE);
+                return 1;
+            }
+            else
+                chunkSize = atol(optarg);
+            break;
+
+        case 'm':
+            chunkSource = MMAP_SOURCE;
+            break;
+
+        case 'a':
+            chunkSource = ATOMIC_SOURCE;
+            break;
+
+        case 's':
+            chunkSource = STEALING_SOURCE;
+            break;
+
+        case 'p':
+            chunkSource = PREFETCH_SOURCE;
+            if (atoi(optarg) < 1)
+            {
+                fprintf(stderr, "Invalid prefetch depth: %s\n", optarg);
+                return 1;
+            }
+            prefetchDepth = atoi(optarg);
+            break;
+
+        case 'h':
+            printUsage();
+            return 0;
+
+        default:
+            printUsage();
+            return 1;
+        }
+    }
+    if (nWorkers < 1)
+        nWorkers = 1;
+
     //Parse file names
-    if (argc == 1)
+    if (optind == argc)
     {
-        fprintf(stderr, "USAGE: ./countWords fileName [fileName ...]\n");
+        printUsage();
         return 1;
     }
     
     //Save file names and count in shared memory
-    int nFiles = argc-1;
+    int nFiles = argc - optind;
     char fileNames[nFiles][MAX_FILE_NAME_SIZE];
 
     for(int i = 0; i < nFiles; i++)
     {
-        strcpy(fileNames[i], argv[i+1]);
+        strcpy(fileNames[i], argv[optind + i]);
     }
-    if(sm_initialize(nFiles, fileNames) == FAILURE)
+    if(sm_initialize(nFiles, fileNames, chunkSource, nWorkers, chunkSize, prefetchDepth) == FAILURE)
     {
         fprintf(stderr, "Fail to initialize shared memory");
         exit(EXIT_FAILURE);
     }
+    printf("Workers = %d, chunk size = %u bytes\n", nWorkers, sm_getChunkSize());
 
     //Create workers
-    pthread_t workers[N];
-    unsigned int workersID[N];
+    pthread_t workers[nWorkers];
+    unsigned int workersID[nWorkers];
+    statusWorkers = (int *) malloc(nWorkers * sizeof(int));
+    if (statusWorkers == NULL)
+    {
+        perror("malloc error");
+        exit(EXIT_FAILURE);
+    }
 
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < nWorkers; i++)
         workersID[i] = i;
 
     //Determine executing start time
     struct timespec startTime, endTime;
     clock_gettime(CLOCK_MONOTONIC, &startTime);
 
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < nWorkers; i++)
         if (pthread_create(&workers[i], NULL, work, (void *) &workersID[i]) != 0) /* thread producer */
         {
             perror("Error on creating workers");
@@ -82,7 +162,7 @@ int main(int argc, char *argv[])
 
     //Wait for all workers to finish
     int *executionStatus;
-    for (int i = 0; i < N; i++)
+    for (int i = 0; i < nWorkers; i++)
     {
         if (pthread_join(workers[i], (void *)&executionStatus) != 0) /* thread producer */
         {
@@ -97,18 +177,51 @@ int main(int argc, char *argv[])
     clock_gettime(CLOCK_MONOTONIC, &endTime);
     printf ("\nElapsed time = %.6f s\n",  (endTime.tv_sec - startTime.tv_sec) / 1.0 + (endTime.tv_nsec - startTime.tv_nsec) / 1000000000.0);
 
+    if (chunkSource == PREFETCH_SOURCE)
+    {
+        PrefetchStatistics statistics;
+        pr_getStatistics(&statistics);
+        printf("Prefetch queue depth = %.2f of %u (chunks = %lu, worker waits = %lu, reader waits = %lu)\n",
+               statistics.averageQueueDepth, statistics.depth, statistics.chunks, statistics.workerWaits, statistics.readerWaits);
+    }
+
     //Get results
     struct sResults results[nFiles];
     sm_getResults(results);
 
+    printf("Lock acquisitions avoided = %lu\n", sm_getLockAcquisitionsAvoided());
+    if (chunkSource == STEALING_SOURCE)
+        printf("Chunks stolen = %lu\n", sm_getStolenChunks());
+
     //print results for each file
     for(int i = 0; i < nFiles; i++)
         printResults(results[i]);
 
-    sm_close();
+    if (sm_close() == FAILURE)
+    {
+        fprintf(stderr, "Fail to read the files");
+        exit(EXIT_FAILURE);
+    }
+    free(statusWorkers);
     exit(EXIT_SUCCESS);
 }
 
+/** \brief Prints the command line usage to stderr.
+*/
+static void printUsage()
+{
+    fprintf(stderr, "USAGE: ./countWords [-t threads] [-c chunkBytes | -c auto] [-m | -a | -s | -p depth] fileName [fileName ...]\n"
+                    "  fileName - reads the standard input (not with -m, -a or -s)\n"
+                    "  -t   number of worker threads (default: number of online CPUs)\n"
+                    "  -c   size of the chunks of data in bytes (default: %d), auto picks it from the\n"
+                    "       total input size and the number of worker threads\n"
+                    "  -m   memory map the files, workers process chunks in place\n"
+                    "  -a   memory map the files, workers claim chunks with atomic operations\n"
+                    "  -s   memory map the files, chunks are dealt to per worker deques and idle workers steal them\n"
+                    "  -p   a reader thread keeps depth chunks ready ahead of the workers (default: %d)\n",
+            DATA_BUFFER_SIZE, PREFETCH_DEPTH);
+}
+
 /** \brief Prints results of a given file.
  * 
  *  This function prints to stdout the corresponding processing results of 
@@ -134,107 +247,55 @@ void printResults(const Results results)
  *  
  *  At the end the processing, the total number of words, words beginning in vowel
  *  and words ending in consonant, of the corresponding piece of data, is determined.
+ *  The piece of data is scanned by the vector kernel selected for the running CPU.
  * 
  *  \param args Pointer to defined worker identification (int)
 */
 static void * work(void * args)
 {
+    int id = *((int *) args);
+
+    //chunks read from the file streams are copied into the worker's buffer
+    unsigned char *buffer = NULL;
+    if (chunkSource == READ_SOURCE)
+    {
+        buffer = (unsigned char *) malloc(sm_getChunkSize());
+        if (buffer == NULL)
+        {
+            perror("malloc error");
+            statusWorkers[id] = EXIT_FAILURE;
+            pthread_exit(&statusWorkers[id]);
+        }
+    }
+
     while(true)
     {
-        int id = *((int *) args);
-        unsigned char data[DATA_BUFFER_SIZE];
+        const unsigned char *data = buffer;
         unsigned int size;
         FileHandler fileHandler;
-        bool workToDo = sm_getChunkOfData(id, data, &size, &fileHandler);
+        bool workToDo;
+
+        if (chunkSource == MMAP_SOURCE) //process the chunk in place
+            workToDo = sm_getChunkView(id, &data, &size, &fileHandler);
+        else if (chunkSource == ATOMIC_SOURCE)
+            workToDo = sm_claimChunk(id, &data, &size, &fileHandler);
+        else if (chunkSource == STEALING_SOURCE)
+            workToDo = sm_stealChunk(id, &data, &size, &fileHandler);
+        else if (chunkSource == PREFETCH_SOURCE)
+            workToDo = sm_getPrefetchedChunk(id, &data, &size, &fileHandler);
+        else
+            workToDo = sm_getChunkOfData(id, buffer, &size, &fileHandler);
 
         if(!workToDo) //end work life cycle if there is no more work to do
         {
+            free(buffer);
             statusWorkers[id] = EXIT_SUCCESS;
             pthread_exit(&statusWorkers[id]);
         }
 
-        unsigned int totalWords = 0;
-        unsigned int totalWordsEndingInConsoant = 0;
-        unsigned int totalWordsBeginningInVowel = 0;
-        enum CharacterType charType;
-        enum CharacterType lastCharType;
-        bool inWord = false;
-
-
-        unsigned int utf8Char;
-        int utf8CharSize;
-        int dataIdx = 0;
-        // Block of text
-        do
-        {
-            utf8Char = data[dataIdx];
-            utf8CharSize = getUTF8CharSize(data[dataIdx]);
-            
-            for(int i = 1; i < utf8CharSize; i++)
-            {
-                utf8Char = (utf8Char << 8) | data[dataIdx + i];
-            }
-            dataIdx += utf8CharSize;
-            charType = getUTF8CharType(utf8Char);
-
-            switch (inWord)
-            {
-            case false:
-                switch (charType)
-                {
-                case VOWEL:
-                    totalWordsBeginningInVowel++;
-                case CONSOANT:
-                case UNDERSCORE:
-                case DIGIT:
-                    totalWords++;
-                    inWord = true;
-                    break;
-
-                default:
-                    break;
-                }
-
-                break;
-
-            case true:
-                switch (charType)
-                {
-                case DELIMITER:
-                    if (lastCharType == CONSOANT)
-                        totalWordsEndingInConsoant++;
-
-                    inWord = false;
-                    break;
-
-                default:
-                    break;
-                }
-                break;
-            }
-            /*if(charType == VOWEL)
-                printf("VOWEL\n");
-            if(charType == CONSOANT)
-                printf("CONSOANT\n");
-            if(charType == UNDERSCORE)
-                printf("UNDERSCORE\n");
-            if(charType == DIGIT)
-                printf("DIGIT\n");
-            if(charType == DELIMITER)
-                printf("DELIMITER\n");
-            if(charType == ERROR)
-                printf("ERROR\n");         
-            printf("%x\n", utf8Char); */
-            if (charType != NOT_DEFINED) // ignore case NOT_DEFINED
-                lastCharType = charType; 
-
-        } while (dataIdx < size);
-
         Count count;
-        count.words = totalWords;
-        count.wordsBeginningInVowel = totalWordsBeginningInVowel;
-        count.wordsEndingInConsoant = totalWordsEndingInConsoant;
-        
+        scanChunk(data, size, &count.words, &count.wordsBeginningInVowel, &count.wordsEndingInConsoant);
+
         sm_registerResult(id, fileHandler, &count);
     }
 }
\ No newline at end of file
@@ -0,0 +1,442 @@
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "prefetchReader.h"
+#include "utf8.h"
+
+
+/**
+ *  \file prefetchReader.c
+ *
+ *  \brief Prefetching reader implementation
+ *
+ *  Synchronization based on monitors.
+ *
+ *  The reader thread reads each file with pread, or read when the file is not seekable, into free
+ *  buffers of the ring and hands them over to the workers in file order. Ready buffers are kept in
+ *  a FIFO, free buffers in a stack so that the most recently used, cache hot, buffer is refilled first.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief total number of files */
+static unsigned int numberOfFiles;
+
+/** \brief file descriptors of the files */
+static int *fds;
+
+/** \brief size of the chunks of data */
+static unsigned int chunkSize;
+
+/** \brief number of buffers in the ring */
+static unsigned int nSlots;
+
+/** \brief number of chunks read ahead of the workers */
+static unsigned int readAhead;
+
+/** \brief storage of the ring, nSlots buffers of chunkSize bytes */
+static unsigned char *buffers;
+
+/** \brief size of the chunk in each buffer */
+static unsigned int *slotSize;
+
+/** \brief file of the chunk in each buffer */
+static unsigned int *slotFile;
+
+/** \brief FIFO of buffers holding ready chunks */
+static unsigned int *readySlots;
+
+/** \brief insertion pointer of the FIFO of ready buffers */
+static unsigned int ii;
+
+/** \brief retrieval pointer of the FIFO of ready buffers */
+static unsigned int ri;
+
+/** \brief number of ready buffers */
+static unsigned int readyCount;
+
+/** \brief stack of free buffers */
+static unsigned int *freeSlots;
+
+/** \brief number of free buffers */
+static unsigned int freeCount;
+
+/** \brief flag signaling all the files have been read */
+static bool done;
+
+/** \brief sum of the number of ready buffers found by the workers */
+static unsigned long queueDepthSum;
+
+/** \brief number of chunks retrieved by the workers */
+static unsigned long retrievals;
+
+/** \brief number of times a worker found no ready chunk */
+static unsigned long workerWaits;
+
+/** \brief number of times the reader found no free buffer */
+static unsigned long readerWaits;
+
+/** \brief reader thread */
+static pthread_t reader;
+
+/** \brief reader thread return status */
+static int statusReader;
+
+/** \brief locking flag which warrants mutual exclusion inside the monitor */
+static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
+
+/** \brief reader synchronization point when there is no free buffer or depth chunks are ready */
+static pthread_cond_t ringFull = PTHREAD_COND_INITIALIZER;
+
+/** \brief workers synchronization point when there is no ready chunk */
+static pthread_cond_t ringEmpty = PTHREAD_COND_INITIALIZER;
+
+/** \brief worker threads return status array */
+extern int *statusWorkers;
+
+/** \brief Enters the monitor on behalf of the reader thread */
+static void readerLock()
+{
+    if ((statusReader = pthread_mutex_lock(&accessCR)) != 0)
+    {
+        errno = statusReader;
+        perror("error on entering monitor");
+        statusReader = EXIT_FAILURE;
+        pthread_exit(&statusReader);
+    }
+}
+
+/** \brief Exits the monitor on behalf of the reader thread */
+static void readerUnlock()
+{
+    if ((statusReader = pthread_mutex_unlock(&accessCR)) != 0)
+    {
+        errno = statusReader;
+        perror("error on exiting monitor");
+        statusReader = EXIT_FAILURE;
+        pthread_exit(&statusReader);
+    }
+}
+
+/** \brief Takes a free buffer, waiting for the workers to release one if needed
+ *
+ *  \returns free buffer
+ */
+static unsigned int acquireFreeSlot()
+{
+    readerLock();
+
+    //the reader stays at most readAhead chunks ahead of the workers
+    if (freeCount == 0 || readyCount >= readAhead)
+        readerWaits++;
+    while (freeCount == 0 || readyCount >= readAhead)
+    {
+        if ((statusReader = pthread_cond_wait(&ringFull, &accessCR)) != 0)
+        {
+            errno = statusReader;
+            perror("error on waiting in ringFull");
+            statusReader = EXIT_FAILURE;
+            pthread_exit(&statusReader);
+        }
+    }
+    unsigned int slot = freeSlots[--freeCount];
+
+    readerUnlock();
+    return slot;
+}
+
+/** \brief Hands a filled buffer over to the workers
+ *
+ *  \param slot filled buffer
+ *  \param size size of the chunk
+ *  \param fileIdx file of the chunk
+ */
+static void publishSlot(unsigned int slot, unsigned int size, unsigned int fileIdx)
+{
+    readerLock();
+
+    slotSize[slot] = size;
+    slotFile[slot] = fileIdx;
+    readySlots[ii] = slot;
+    ii = (ii + 1) % nSlots;
+    readyCount++;
+    pthread_cond_signal(&ringEmpty);
+
+    readerUnlock();
+}
+
+/** \brief Signals the workers that every file has been read */
+static void finishReading()
+{
+    readerLock();
+    done = true;
+    pthread_cond_broadcast(&ringEmpty);
+    readerUnlock();
+}
+
+/** \brief Fills a buffer from a file
+ *
+ *  \param fd file descriptor
+ *  \param buffer buffer
+ *  \param length number of bytes to read
+ *  \param[in,out] offset position of the file, used while the file is seekable
+ *  \param[in,out] seekable false once pread failed on the file
+ *
+ *  \returns number of bytes read, less than length only at the end of the file, -1 on error
+ */
+static ssize_t fillBuffer(int fd, unsigned char *buffer, unsigned int length, off_t *offset, bool *seekable)
+{
+    unsigned int total = 0;
+    while (total < length)
+    {
+        ssize_t n = *seekable ? pread(fd, buffer + total, length - total, *offset) : read(fd, buffer + total, length - total);
+        if (n == -1 && *seekable && errno == ESPIPE) //pipes are read sequentially
+        {
+            *seekable = false;
+            continue;
+        }
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n == -1)
+            return -1;
+        if (n == 0)
+            break;
+
+        total += n;
+        *offset += n;
+    }
+    return total;
+}
+
+/** \brief Reader thread routine.
+ *
+ *  Reads every file in order into the ring of buffers. The bytes after the last delimiter of a full
+ *  buffer are carried over to the beginning of the next one.
+ *
+ *  \param args not used
+ */
+static void *readFiles(void *args)
+{
+    unsigned char *carry = (unsigned char *) malloc(chunkSize);
+    if (carry == NULL)
+    {
+        perror("malloc error");
+        finishReading();
+        statusReader = EXIT_FAILURE;
+        pthread_exit(&statusReader);
+    }
+
+    for (unsigned int fileIdx = 0; fileIdx < numberOfFiles; fileIdx++)
+    {
+        int fd = fds[fileIdx];
+        posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        if (fileIdx + 1 < numberOfFiles) //let the kernel start reading the next file
+            posix_fadvise(fds[fileIdx + 1], 0, 0, POSIX_FADV_WILLNEED);
+
+        off_t offset = 0;
+        bool seekable = true;
+        bool endOfFile = false;
+        unsigned int carrySize = 0;
+        while (!endOfFile)
+        {
+            unsigned int slot = acquireFreeSlot();
+            unsigned char *buffer = buffers + (size_t) slot * chunkSize;
+
+            memcpy(buffer, carry, carrySize);
+            ssize_t n = fillBuffer(fd, buffer + carrySize, chunkSize - carrySize, &offset, &seekable);
+            if (n == -1)
+            {
+                perror("error on reading file");
+                free(carry);
+                finishReading();
+                statusReader = EXIT_FAILURE;
+                pthread_exit(&statusReader);
+            }
+
+            unsigned int size = carrySize + n;
+            carrySize = 0;
+            if (size < chunkSize)
+                endOfFile = true;
+            else
+            {
+                //keep the bytes after the last delimiter for the next chunk, a chunk without
+                //delimiters is given as is
+                unsigned int end = getUTF8LastDelimiterEnd(buffer, size);
+                if (end > 0)
+                {
+                    carrySize = size - end;
+                    memcpy(carry, buffer + end, carrySize);
+                    size = end;
+                }
+            }
+
+            if (size > 0)
+                publishSlot(slot, size, fileIdx);
+            else //nothing left in the file, the buffer is still free
+            {
+                readerLock();
+                freeSlots[freeCount++] = slot;
+                readerUnlock();
+            }
+        }
+    }
+
+    free(carry);
+    finishReading();
+    statusReader = EXIT_SUCCESS;
+    pthread_exit(&statusReader);
+}
+
+int pr_start(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE], unsigned int size, unsigned int depth, int nWorkers)
+{
+    numberOfFiles = nFiles;
+    chunkSize = size;
+    readAhead = depth;
+    nSlots = depth + nWorkers;            //one buffer per worker and depth ready ones, one of them being filled
+    ii = ri = 0;
+    readyCount = 0;
+    done = false;
+    queueDepthSum = retrievals = workerWaits = readerWaits = 0;
+
+    fds = (int *) malloc(nFiles * sizeof(int));
+    buffers = (unsigned char *) malloc((size_t) nSlots * chunkSize);
+    slotSize = (unsigned int *) malloc(nSlots * sizeof(unsigned int));
+    slotFile = (unsigned int *) malloc(nSlots * sizeof(unsigned int));
+    readySlots = (unsigned int *) malloc(nSlots * sizeof(unsigned int));
+    freeSlots = (unsigned int *) malloc(nSlots * sizeof(unsigned int));
+    if (fds == NULL || buffers == NULL || slotSize == NULL || slotFile == NULL || readySlots == NULL || freeSlots == NULL)
+    {
+        perror("malloc error");
+        return -1;
+    }
+
+    for (freeCount = 0; freeCount < nSlots; freeCount++)
+        freeSlots[freeCount] = nSlots - 1 - freeCount;
+
+    for (int i = 0; i < nFiles; i++)
+    {
+        fds[i] = strcmp(files[i], STDIN_FILE_NAME) == 0 ? STDIN_FILENO : open(files[i], O_RDONLY);
+        if (fds[i] == -1)
+        {
+            perror("open error");
+            return -1;
+        }
+    }
+
+    if (pthread_create(&reader, NULL, readFiles, NULL) != 0)
+    {
+        perror("Error on creating reader");
+        return -1;
+    }
+
+    return 0;
+}
+
+bool pr_getChunk(int id, const unsigned char **data, unsigned int *size, unsigned int *fileIdx, unsigned int *slot)
+{
+    if ((statusWorkers[id] = pthread_mutex_lock(&accessCR)) != 0)
+    {
+        errno = statusWorkers[id];
+        perror("error on entering monitor");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+
+    unsigned int queueDepth = readyCount;
+    if (readyCount == 0 && !done)
+        workerWaits++;
+    while (readyCount == 0 && !done)
+    {
+        if ((statusWorkers[id] = pthread_cond_wait(&ringEmpty, &accessCR)) != 0)
+        {
+            errno = statusWorkers[id];
+            perror("error on waiting in ringEmpty");
+            statusWorkers[id] = EXIT_FAILURE;
+            pthread_exit(&statusWorkers[id]);
+        }
+    }
+
+    bool moreWorkToDo = readyCount > 0;
+    if (moreWorkToDo)
+    {
+        *slot = readySlots[ri];
+        ri = (ri + 1) % nSlots;
+        readyCount--;
+        pthread_cond_signal(&ringFull);
+        queueDepthSum += queueDepth;
+        retrievals++;
+
+        *data = buffers + (size_t) *slot * chunkSize;
+        *size = slotSize[*slot];
+        *fileIdx = slotFile[*slot];
+    }
+
+    if ((statusWorkers[id] = pthread_mutex_unlock(&accessCR)) != 0)
+    {
+        errno = statusWorkers[id];
+        perror("error on exiting monitor");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+
+    return moreWorkToDo;
+}
+
+void pr_releaseChunk(int id, unsigned int slot)
+{
+    if ((statusWorkers[id] = pthread_mutex_lock(&accessCR)) != 0)
+    {
+        errno = statusWorkers[id];
+        perror("error on entering monitor");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+
+    freeSlots[freeCount++] = slot;
+    pthread_cond_signal(&ringFull);
+
+    if ((statusWorkers[id] = pthread_mutex_unlock(&accessCR)) != 0)
+    {
+        errno = statusWorkers[id];
+        perror("error on exiting monitor");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+}
+
+void pr_getStatistics(PrefetchStatistics *statistics)
+{
+    statistics->depth = readAhead;
+    statistics->averageQueueDepth = retrievals == 0 ? 0 : (double) queueDepthSum / retrievals;
+    statistics->chunks = retrievals;
+    statistics->workerWaits = workerWaits;
+    statistics->readerWaits = readerWaits;
+}
+
+int pr_close()
+{
+    int *status;
+    if (pthread_join(reader, (void *) &status) != 0)
+    {
+        perror("error on waiting for reader");
+        return -1;
+    }
+
+    for (unsigned int i = 0; i < numberOfFiles; i++)
+        if (fds[i] != STDIN_FILENO)
+            close(fds[i]);
+
+    free(fds);
+    free(buffers);
+    free(slotSize);
+    free(slotFile);
+    free(readySlots);
+    free(freeSlots);
+
+    return *status == EXIT_SUCCESS ? 0 : -1;
+}
@@ -0,0 +1,97 @@
+#ifndef PREFETCH_READER_H
+#define PREFETCH_READER_H
+
+#include <stdbool.h>
+#include "probConst.h"
+
+/**
+ *  \file prefetchReader.h
+ *
+ *  \brief Prefetching reader header
+ *
+ *  A dedicated reader thread reads the files, one after the other, into a ring of chunk buffers
+ *  ahead of the workers, so that disk latency overlaps with counting. Every chunk ends right after
+ *  a delimiter, the bytes after the last delimiter begin the next chunk of the same file.
+ *
+ *  Synchronization based on monitors.
+ *
+ *  Definition of the operations carried out by the workers:
+ *     \li pr_getChunk
+ *     \li pr_releaseChunk.
+ *
+ *  Definition of the operations carried out by the main thread:
+ *     \li pr_start
+ *     \li pr_close
+ *     \li pr_getStatistics.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Occupation of the ring of chunks during the whole run */
+struct sPrefetchStatistics
+{
+    unsigned int depth;             /*!< Number of chunks the reader may read ahead of the workers */
+    double averageQueueDepth;       /*!< Average number of ready chunks found by the workers */
+    unsigned long chunks;           /*!< Number of chunks read */
+    unsigned long workerWaits;      /*!< Number of times a worker found no ready chunk */
+    unsigned long readerWaits;      /*!< Number of times the reader waited for a free buffer or for the workers to catch up */
+};
+typedef struct sPrefetchStatistics PrefetchStatistics;
+
+/** \brief Opens the files and launches the reader thread
+ *
+ *  Operation carried out by main thread.
+ *  The ring holds depth + nWorkers buffers: one being processed by each worker and up to depth
+ *  chunks read ahead, the one being filled by the reader included. The file name STDIN_FILE_NAME stands for the standard input.
+ *
+ *  \param nFiles Total number of files
+ *  \param files Array containing the names of all files
+ *  \param chunkSize Size of the chunks of data
+ *  \param depth Number of chunks read ahead of the workers
+ *  \param nWorkers Number of worker threads
+ *
+ *  \returns 0 on success, -1 otherwise
+ */
+int pr_start(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE], unsigned int chunkSize, unsigned int depth, int nWorkers);
+
+/** \brief Retrieves the next ready chunk of data
+ *
+ *  Operation carried out by worker thread.
+ *  Blocks until the reader has a chunk ready. The chunk stays valid until it is released.
+ *
+ *  \param id Worker thread id
+ *  \param[out] data Pointer to the beginning of the chunk of data
+ *  \param[out] size The size of the chunk of data
+ *  \param[out] fileIdx Index of the file the chunk belongs to
+ *  \param[out] slot Buffer holding the chunk, to be given to pr_releaseChunk
+ *
+ *  \returns true If a new chunk was retrieved, false if every file has been read and processed
+ */
+bool pr_getChunk(int id, const unsigned char **data, unsigned int *size, unsigned int *fileIdx, unsigned int *slot);
+
+/** \brief Gives a processed chunk's buffer back to the reader
+ *
+ *  Operation carried out by worker thread.
+ *
+ *  \param id Worker thread id
+ *  \param slot Buffer holding the chunk
+ */
+void pr_releaseChunk(int id, unsigned int slot);
+
+/** \brief Gets the occupation of the ring of chunks
+ *
+ *  Operation carried out by main thread, after all workers have terminated.
+ *
+ *  \param[out] statistics ring occupation
+ */
+void pr_getStatistics(PrefetchStatistics *statistics);
+
+/** \brief Waits for the reader thread and frees the ring of chunks
+ *
+ *  Operation carried out by main thread, after all workers have terminated.
+ *
+ *  \returns 0 if every file was read successfully, -1 otherwise
+ */
+int pr_close();
+
+#endif /* PREFETCH_READER_H */
@@ -12,13 +12,28 @@
  */
 
 
-/** \brief number of workers */
-#define N   8
+/** \brief minimum size of worker's data chunk, used by the auto-tune mode and to validate -c */
+#define MIN_DATA_BUFFER_SIZE 256
 
 /** \brief maximum file path size */
 #define MAX_FILE_NAME_SIZE 50       
 
-/** \brief size of worker's data chuck buffer */
-#define DATA_BUFFER_SIZE 2 << 12
+/** \brief file name standing for the standard input */
+#define STDIN_FILE_NAME "-"
+
+/** \brief default size of worker's data chuck buffer */
+#define DATA_BUFFER_SIZE (2 << 12)
+
+/** \brief maximum size of worker's data chunk chosen by the auto-tune mode */
+#define MAX_AUTO_DATA_BUFFER_SIZE (4 << 20)
+
+/** \brief number of chunks of data per worker targeted by the auto-tune mode */
+#define AUTO_CHUNKS_PER_WORKER 16
+
+/** \brief default number of chunks of data read ahead of the workers by the prefetching reader */
+#define PREFETCH_DEPTH 8
+
+/** \brief size of a cache line, results of different workers never share one */
+#define CACHE_LINE_SIZE 64
 
 #endif /* PROB_CONST_H_ */
\ No newline at end of file
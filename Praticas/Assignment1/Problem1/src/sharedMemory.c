@@ -3,9 +3,14 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <stdbool.h>
-#include <string.h>
+#include <stdatomic.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "sharedMemory.h"
 #include "utf8.h"
+#include "prefetchReader.h"
 
 
 /**
@@ -17,6 +22,10 @@
  * 
  *  Definition of the operations carried out by the workers:
  *     \li sm_getChunkOfData
+ *     \li sm_getChunkView
+ *     \li sm_claimChunk
+ *     \li sm_getPrefetchedChunk
+ *     \li sm_stealChunk
  *     \li sm_registerResult.
  * 
  *  Definition of the operations carried out by the main thread:
@@ -33,17 +42,79 @@ static unsigned int fileIdx;
 /** \brief total number of files */
 static unsigned int numberOfFiles;
 
+/** \brief source of the chunks of data */
+static enum ChunkSource chunkSource;
+
+/** \brief number of worker threads */
+static int numberOfWorkers;
+
+/** \brief size of the chunks of data */
+static unsigned int chunkSize;
+
 /** \brief Information regarding a file and it's counting results */
 struct sFileHandler
 {
-    Count count;        /*!< Counting results */
-    char *fileName;     /*!< File name */
-    FILE *ptrFile;      /*!< File stream */
+    Count count;                /*!< Counting results */
+    char *fileName;             /*!< File name */
+    FILE *ptrFile;              /*!< File stream (READ_SOURCE) */
+    unsigned char *carry;       /*!< Unfinished tail of the last chunk of data read (READ_SOURCE) */
+    unsigned int carrySize;     /*!< Size of the unfinished tail (READ_SOURCE) */
+    const unsigned char *text;  /*!< Memory mapped file (MMAP_SOURCE, ATOMIC_SOURCE, STEALING_SOURCE) */
+    size_t fileSize;            /*!< File size (MMAP_SOURCE, ATOMIC_SOURCE, STEALING_SOURCE) */
+    size_t offset;              /*!< Beginning of the next claim of chunkSize bytes, not aligned (MMAP_SOURCE) */
+    size_t streamStart;         /*!< Beginning of the file in the logical stream (ATOMIC_SOURCE) */
 };
 
 /** \brief List of file handlers */
 static FileHandler handlers;
 
+/** \brief Counting results of a single worker, never shared with other workers */
+struct sWorkerResults
+{
+    unsigned long registrations;    /*!< Number of registered chunks of data */
+    int prefetchSlot;               /*!< Buffer of the prefetched chunk being processed, -1 if none (PREFETCH_SOURCE) */
+    Count counts[];                 /*!< Counting results of each file */
+};
+typedef struct sWorkerResults WorkerResults;
+
+/** \brief Counting results of every worker, each worker's block is padded to whole cache lines */
+static unsigned char *workerResults;
+
+/** \brief Size of each worker's block of results */
+static size_t workerResultsSize;
+
+/** \brief next unclaimed byte of the logical stream (ATOMIC_SOURCE) */
+static atomic_size_t streamOffset;
+
+/** \brief size of the logical stream (ATOMIC_SOURCE) */
+static size_t streamSize;
+
+/** \brief Range of a file making up a chunk of data, before moving its ends to the next delimiters */
+struct sChunkDescriptor
+{
+    unsigned int fileIdx;       /*!< File index */
+    size_t begin;               /*!< Beginning of the range */
+    size_t end;                 /*!< End of the range */
+};
+typedef struct sChunkDescriptor ChunkDescriptor;
+
+/** \brief Deque of chunk descriptors of a worker, the owner pops from the bottom and thieves steal from the top */
+struct sWorkQueue
+{
+    _Alignas(CACHE_LINE_SIZE) pthread_mutex_t lock;    /*!< locking flag which warrants mutual exclusion inside the deque */
+    ChunkDescriptor *chunks;    /*!< Descriptors given to the worker at initialization */
+    unsigned int top;           /*!< Next descriptor to steal */
+    unsigned int bottom;        /*!< One past the next descriptor to pop */
+    unsigned long steals;       /*!< Number of descriptors stolen by the worker */
+};
+typedef struct sWorkQueue WorkQueue;
+
+/** \brief Chunk descriptors of every file (STEALING_SOURCE) */
+static ChunkDescriptor *chunkDescriptors;
+
+/** \brief Deque of each worker (STEALING_SOURCE) */
+static WorkQueue *workQueues;
+
 /** \brief flag to check if sharedMemory is initialized */
 static bool initialized = false;
 
@@ -51,9 +122,212 @@ static bool initialized = false;
 static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
 
 /** \brief worker threads return status array */
-int statusWorkers[N];
+extern int *statusWorkers;
+
+/** \brief Gets the counting results of a worker
+ *
+ *  \param id Worker thread id
+ *
+ *  \returns worker's counting results
+ */
+static inline WorkerResults *getWorkerResults(int id)
+{
+    return (WorkerResults *) (workerResults + id * workerResultsSize);
+}
+
+/** \brief Memory maps a file.
+ *
+ *  \param handler file handler, receives the mapping and the file size
+ *
+ *  \returns FAILURE If an error occurs, otherwise SUCCESS
+ */
+static int mapFile(FileHandler handler)
+{
+    int fd = open(handler->fileName, O_RDONLY);
+    if (fd == -1)
+    {
+        perror("open error");
+        return FAILURE;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        perror("fstat error");
+        close(fd);
+        return FAILURE;
+    }
+
+    handler->fileSize = fileStat.st_size;
+    handler->offset = 0;
+    handler->text = NULL;
+
+    //empty files can not be mapped and have no chunks
+    if (handler->fileSize > 0)
+    {
+        void *text = mmap(NULL, handler->fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED)
+        {
+            perror("mmap error");
+            close(fd);
+            return FAILURE;
+        }
+        madvise(text, handler->fileSize, MADV_SEQUENTIAL);
+        handler->text = (const unsigned char *) text;
+    }
+
+    close(fd);
+    return SUCCESS;
+}
+
+/** \brief Finds the end of a chunk of data.
+ *
+ *  Starting at the given position, looks for the first delimiter character and returns the position
+ *  right after it. If the position is in the middle of a character the search begins at the next one.
+ *
+ *  \param text text being processed
+ *  \param length size of the text
+ *  \param pos minimum end of the chunk
+ *
+ *  \returns end of the chunk, length if there is no delimiter after pos
+ */
+static size_t findChunkEnd(const unsigned char *text, size_t length, size_t pos)
+{
+    //skip continuation bytes of the current character
+    while (pos < length && (text[pos] & 0xC0) == 0x80)
+        pos++;
+
+    while (pos < length)
+    {
+        unsigned int characterSize = getUTF8CharSize(text[pos]);
+        if (characterSize == 0)
+            characterSize = 1;
+        if (characterSize > length - pos)
+            return length;
+
+        unsigned int utf8Char = text[pos];
+        for (int i = 1; i < characterSize; i++)
+            utf8Char = (utf8Char << 8) | text[pos + i];
+
+        pos += characterSize;
+        if (getUTF8CharType(utf8Char) == DELIMITER)
+            return pos;
+    }
+    return length;
+}
+
+/** \brief Splits the memory mapped files in chunk descriptors and deals them to the workers' deques.
+ *
+ *  Every file is split in ranges of chunkSize bytes from its size alone, the text is only read when
+ *  a range is taken. Each worker is given a contiguous run of about the same number of descriptors.
+ *
+ *  \returns FAILURE If an error occurs, otherwise SUCCESS
+ */
+static int buildWorkQueues()
+{
+    size_t nDescriptors = 0;
+    for (int i = 0; i < numberOfFiles; i++)
+        nDescriptors += (handlers[i].fileSize + chunkSize - 1) / chunkSize;
+
+    chunkDescriptors = (ChunkDescriptor *) malloc((nDescriptors + 1) * sizeof(ChunkDescriptor));
+    workQueues = (WorkQueue *) aligned_alloc(CACHE_LINE_SIZE, numberOfWorkers * sizeof(WorkQueue));
+    if (chunkDescriptors == NULL || workQueues == NULL)
+    {
+        perror("malloc error");
+        return FAILURE;
+    }
+
+    size_t n = 0;
+    for (int i = 0; i < numberOfFiles; i++)
+        for (size_t begin = 0; begin < handlers[i].fileSize; begin += chunkSize)
+        {
+            size_t end = begin + chunkSize;
+            chunkDescriptors[n++] = (ChunkDescriptor) {i, begin, end < handlers[i].fileSize ? end : handlers[i].fileSize};
+        }
+
+    for (int id = 0; id < numberOfWorkers; id++)
+    {
+        if (pthread_mutex_init(&workQueues[id].lock, NULL) != 0)
+        {
+            perror("pthread_mutex_init error");
+            return FAILURE;
+        }
+        size_t first = nDescriptors * id / numberOfWorkers;
+        size_t last = nDescriptors * (id + 1) / numberOfWorkers;
+        workQueues[id].chunks = chunkDescriptors + first;
+        workQueues[id].top = 0;
+        workQueues[id].bottom = last - first;
+        workQueues[id].steals = 0;
+    }
+
+    return SUCCESS;
+}
+
+/** \brief Takes a chunk descriptor from a worker's deque
+ *
+ *  \param id Worker thread id
+ *  \param queue deque
+ *  \param steal true to take from the top, false to take from the bottom
+ *  \param[out] descriptor chunk descriptor
+ *
+ *  \returns true If a descriptor was taken, false if the deque is empty
+ */
+static bool takeDescriptor(int id, WorkQueue *queue, bool steal, ChunkDescriptor *descriptor)
+{
+    if (pthread_mutex_lock(&queue->lock) != 0)
+    {
+        perror("error on entering deque");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+
+    bool taken = queue->top < queue->bottom;
+    if (taken)
+        *descriptor = steal ? queue->chunks[queue->top++] : queue->chunks[--queue->bottom];
+
+    if (pthread_mutex_unlock(&queue->lock) != 0)
+    {
+        perror("error on exiting deque");
+        statusWorkers[id] = EXIT_FAILURE;
+        pthread_exit(&statusWorkers[id]);
+    }
+
+    return taken;
+}
+
+/** \brief Chooses the chunk size from the total input size and the number of workers.
+ *
+ *  \param nFiles Total number of files
+ *  \param files Array containing the names of all files
+ *  \param nWorkers Number of worker threads
+ *
+ *  \returns chunk size
+ */
+static unsigned int autoTuneChunkSize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE], int nWorkers)
+{
+    size_t totalSize = 0;
+    for (int i = 0; i < nFiles; i++)
+    {
+        //the size of the standard input is unknown, favour few monitor entries
+        if (strcmp(files[i], STDIN_FILE_NAME) == 0)
+            return MAX_AUTO_DATA_BUFFER_SIZE;
+
+        struct stat fileStat;
+        if (stat(files[i], &fileStat) == 0)
+            totalSize += fileStat.st_size;
+    }
+
+    size_t size = totalSize / ((size_t) nWorkers * AUTO_CHUNKS_PER_WORKER);
+    if (size < MIN_DATA_BUFFER_SIZE)
+        size = MIN_DATA_BUFFER_SIZE;
+    if (size > MAX_AUTO_DATA_BUFFER_SIZE)
+        size = MAX_AUTO_DATA_BUFFER_SIZE;
+
+    return size;
+}
 
-int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE])
+int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE], enum ChunkSource source, int nWorkers, unsigned int size,
+                  unsigned int prefetchDepth)
 {
     if (initialized)
     {
@@ -63,6 +337,11 @@ int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE])
 
     numberOfFiles = nFiles;
     fileIdx = 0;
+    chunkSource = source;
+    numberOfWorkers = nWorkers;
+    chunkSize = (size == 0) ? autoTuneChunkSize(nFiles, files, nWorkers) : size;
+    streamSize = 0;
+    atomic_init(&streamOffset, 0);
 
     handlers = (FileHandler) malloc(nFiles * sizeof(struct sFileHandler));
     if (handlers == NULL)
@@ -71,6 +350,19 @@ int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE])
         return FAILURE;
     }
 
+    //one block of results per worker, so that workers never write to the same cache line
+    workerResultsSize = sizeof(WorkerResults) + nFiles * sizeof(Count);
+    workerResultsSize = (workerResultsSize + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    workerResults = (unsigned char *) aligned_alloc(CACHE_LINE_SIZE, numberOfWorkers * workerResultsSize);
+    if (workerResults == NULL)
+    {
+        perror("aligned_alloc error");
+        return FAILURE;
+    }
+    memset(workerResults, 0, numberOfWorkers * workerResultsSize);
+    for (int id = 0; id < numberOfWorkers; id++)
+        getWorkerResults(id)->prefetchSlot = -1;
+
     for (int i = 0; i < numberOfFiles; i++)
     {
         handlers[i].fileName = (char *) calloc(MAX_FILE_NAME_SIZE, sizeof(char));
@@ -79,10 +371,33 @@ int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE])
         handlers[i].count.wordsEndingInConsoant = 0;
 
         strcpy(handlers[i].fileName , files[i]);
+        handlers[i].ptrFile = NULL;
+        handlers[i].carry = NULL;
+        handlers[i].carrySize = 0;
+
+        bool isStdin = strcmp(handlers[i].fileName, STDIN_FILE_NAME) == 0;
+        if (source == PREFETCH_SOURCE) //files are opened by the reader
+            continue;
+        if (source != READ_SOURCE)  //MMAP_SOURCE, ATOMIC_SOURCE and STEALING_SOURCE
+        {
+            if (isStdin)
+            {
+                fprintf(stderr, "The standard input can not be memory mapped\n");
+                return FAILURE;
+            }
+
+            if (mapFile(&handlers[i]) == FAILURE)
+                return FAILURE;
+
+            //files start at chunk boundaries of the logical stream, so a claim never spans two files
+            handlers[i].streamStart = streamSize;
+            streamSize += (handlers[i].fileSize + chunkSize - 1) / chunkSize * chunkSize;
+            continue;
+        }
 
         //Open file stream
         FILE *ptrFile;
-        ptrFile = fopen(handlers[i].fileName , "rb");
+        ptrFile = isStdin ? stdin : fopen(handlers[i].fileName , "rb");
         if (ptrFile == NULL)
         {
             perror("fopen error");
@@ -90,25 +405,85 @@ int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE])
         }
 
         handlers[i].ptrFile = ptrFile;
+        handlers[i].carry = (unsigned char *) malloc(chunkSize);
+        if (handlers[i].carry == NULL)
+        {
+            perror("malloc error");
+            return FAILURE;
+        }
     }
+
+    if (source == PREFETCH_SOURCE && pr_start(nFiles, files, chunkSize, prefetchDepth, nWorkers) != 0)
+        return FAILURE;
+    if (source == STEALING_SOURCE && buildWorkQueues() == FAILURE)
+        return FAILURE;
     initialized = true;
 
     return SUCCESS;
 }
 
+unsigned int sm_getChunkSize()
+{
+    return chunkSize;
+}
+
+unsigned long sm_getStolenChunks()
+{
+    unsigned long steals = 0;
+    if (chunkSource == STEALING_SOURCE)
+        for (int id = 0; id < numberOfWorkers; id++)
+            steals += workQueues[id].steals;
+
+    return steals;
+}
+
+unsigned long sm_getLockAcquisitionsAvoided()
+{
+    unsigned long registrations = 0;
+    for (int id = 0; id < numberOfWorkers; id++)
+        registrations += getWorkerResults(id)->registrations;
+
+    return registrations;
+}
+
 int sm_close()
 {
+    int status = SUCCESS;
+    if (chunkSource == PREFETCH_SOURCE && pr_close() != 0)
+        status = FAILURE;
+
     for(int i = 0; i < numberOfFiles; i++)
     {
         free(handlers[i].fileName);
-        fclose(handlers[i].ptrFile);
+        if (chunkSource == PREFETCH_SOURCE)
+            continue;
+        if (chunkSource != READ_SOURCE)
+        {
+            if (handlers[i].text != NULL)
+                munmap((void *) handlers[i].text, handlers[i].fileSize);
+        }
+        else
+        {
+            if (handlers[i].ptrFile != stdin)
+                fclose(handlers[i].ptrFile);
+            free(handlers[i].carry);
+        }
     }
     free(handlers);
+    free(workerResults);
 
-    return SUCCESS;
+    if (chunkSource == STEALING_SOURCE)
+    {
+        for (int id = 0; id < numberOfWorkers; id++)
+            pthread_mutex_destroy(&workQueues[id].lock);
+        free(workQueues);
+        free(chunkDescriptors);
+    }
+
+    return status;
 }
 
-bool sm_getChunkOfData(int id, unsigned char data[DATA_BUFFER_SIZE], unsigned int *size, FileHandler *fileHandler)
+bool sm_getChunkOfData(int id, unsigned char *data, unsigned int *size, FileHandler *fileHandler)
 {
     bool moreWorkToDo = true;
     if (pthread_mutex_lock(&accessCR) != 0)
@@ -120,50 +495,36 @@ bool sm_getChunkOfData(int id, unsigned char data[DATA_BUFFER_SIZE], unsigned in
     
     if (fileIdx < numberOfFiles)
     {
-        *fileHandler = &handlers[fileIdx];
-        FILE * file = handlers[fileIdx].ptrFile;
+        FileHandler handler = &handlers[fileIdx];
+        *fileHandler = handler;
 
-        //Get data from file
-        if (( *size = fread(data, sizeof(char), DATA_BUFFER_SIZE, file) ) < DATA_BUFFER_SIZE)
+        //the unfinished tail of the last chunk begins this one, the stream is never seeked
+        memcpy(data, handler->carry, handler->carrySize);
+        *size = handler->carrySize + fread(data + handler->carrySize, sizeof(char), chunkSize - handler->carrySize, handler->ptrFile);
+        handler->carrySize = 0;
+
+        if (*size < chunkSize)
         {
-            if (ferror(file) != 0)
+            if (ferror(handler->ptrFile) != 0)
             {
-                perror("error on entering monitor");
+                perror("error on reading file");
                 statusWorkers[id] = EXIT_FAILURE;
                 pthread_exit(&statusWorkers[id]);
             }
 
-            //no more bytes in file get new file
+            //no more bytes in file get new file, the whole tail is processed
             fileIdx++;
         }
-
-        bool foundDelimiter = false;
-        unsigned int goBackN = 0;
-        
-        //look for last delimiter character in buffer
-        while(!foundDelimiter)
+        else
         {
-            //find beginning of the character
-            unsigned int characterSize;
-            goBackN++;
-            while(( characterSize = getUTF8CharSize(data[*size - goBackN]) ) == 0)
-                goBackN++;
-
-            //check if delimiter
-            unsigned int utf8Char = data[*size - goBackN];
-            for(int i = 1; i < characterSize; i++)
-                utf8Char = (utf8Char << 8) | data[*size - goBackN + i ];
-
-            if(getUTF8CharType(utf8Char) == DELIMITER)
+            //keep the bytes after the last delimiter for the next chunk, a chunk without
+            //delimiters is given as is
+            unsigned int end = getUTF8LastDelimiterEnd(data, *size);
+            if (end > 0)
             {
-                foundDelimiter = true;
-                (*size) = *size - goBackN + characterSize;       //count with last delimiter character
-
-                if(fseek(file, (int)(-goBackN + characterSize), SEEK_CUR) != 0)
-                {
-                    statusWorkers[id] = EXIT_FAILURE;
-                    pthread_exit(&statusWorkers[id]);
-                }
+                handler->carrySize = *size - end;
+                memcpy(handler->carry, data + end, handler->carrySize);
+                *size = end;
             }
         }
     }
@@ -183,27 +544,181 @@ bool sm_getChunkOfData(int id, unsigned char data[DATA_BUFFER_SIZE], unsigned in
     return moreWorkToDo;
 } 
 
-void sm_registerResult(int id, FileHandler fileHandler, Count *count)
+bool sm_getChunkView(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler)
 {
-    if (pthread_mutex_lock(&accessCR) != 0)
+    while (true)
     {
-        perror("error on entering monitor");
-        statusWorkers[id] = EXIT_FAILURE;
-        pthread_exit(&statusWorkers[id]);
+        FileHandler handler = NULL;
+        size_t begin = 0;
+
+        if (pthread_mutex_lock(&accessCR) != 0)
+        {
+            perror("error on entering monitor");
+            statusWorkers[id] = EXIT_FAILURE;
+            pthread_exit(&statusWorkers[id]);
+        }
+
+        while (fileIdx < numberOfFiles)
+        {
+            if (handlers[fileIdx].offset >= handlers[fileIdx].fileSize)
+            {
+                //no more bytes in file get new file
+                fileIdx++;
+                continue;
+            }
+
+            //only the claim is done inside the monitor, the pages of the text are not touched
+            handler = &handlers[fileIdx];
+            begin = handler->offset;
+            handler->offset += chunkSize;
+            break;
+        }
+
+        if (pthread_mutex_unlock(&accessCR) != 0)
+        {
+            perror("error on exiting monitor");
+            statusWorkers[id] = EXIT_FAILURE;
+            pthread_exit(&statusWorkers[id]);
+        }
+
+        if (handler == NULL)
+            return false;
+
+        //both ends move to right after the next delimiter, as in sm_claimChunk
+        size_t end = begin + chunkSize;
+        if (begin > 0)
+            begin = findChunkEnd(handler->text, handler->fileSize, begin);
+        end = findChunkEnd(handler->text, handler->fileSize, end);
+        if (begin >= end) //the whole claim is inside a single word
+            continue;
+
+        *fileHandler = handler;
+        *data = handler->text + begin;
+        *size = end - begin;
+        return true;
     }
-    fileHandler->count.words += count->words;
-    fileHandler->count.wordsBeginningInVowel += count->wordsBeginningInVowel;
-    fileHandler->count.wordsEndingInConsoant += count->wordsEndingInConsoant;
-    if (pthread_mutex_unlock(&accessCR) != 0)
+}
+
+bool sm_claimChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler)
+{
+    while (true)
     {
-        perror("error on exiting monitor");
-        statusWorkers[id] = EXIT_FAILURE;
-        pthread_exit(&statusWorkers[id]);
+        size_t claim = atomic_fetch_add_explicit(&streamOffset, chunkSize, memory_order_relaxed);
+        if (claim >= streamSize)
+            return false;
+
+        //find the file containing the claim, files are sorted by stream start
+        unsigned int low = 0, high = numberOfFiles - 1;
+        while (low < high)
+        {
+            unsigned int middle = (low + high + 1) / 2;
+            if (handlers[middle].streamStart <= claim)
+                low = middle;
+            else
+                high = middle - 1;
+        }
+        FileHandler handler = &handlers[low];
+
+        size_t begin = claim - handler->streamStart;
+        if (begin >= handler->fileSize) //padding at the end of the file
+            continue;
+        size_t end = begin + chunkSize;
+
+        //both ends move to right after the next delimiter, the previous claim ends where this one begins
+        if (begin > 0)
+            begin = findChunkEnd(handler->text, handler->fileSize, begin);
+        end = findChunkEnd(handler->text, handler->fileSize, end);
+        if (begin >= end) //the whole claim is inside a single word
+            continue;
+
+        *fileHandler = handler;
+        *data = handler->text + begin;
+        *size = end - begin;
+        return true;
     }
 }
 
+bool sm_getPrefetchedChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler)
+{
+    WorkerResults *results = getWorkerResults(id);
+
+    //the previous chunk has been processed, its buffer can be refilled
+    if (results->prefetchSlot != -1)
+    {
+        pr_releaseChunk(id, results->prefetchSlot);
+        results->prefetchSlot = -1;
+    }
+
+    unsigned int fileIdx, slot;
+    if (!pr_getChunk(id, data, size, &fileIdx, &slot))
+        return false;
+
+    results->prefetchSlot = slot;
+    *fileHandler = &handlers[fileIdx];
+    return true;
+}
+
+bool sm_stealChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler)
+{
+    while (true)
+    {
+        //own deque first, then the other workers' deques, starting at the next worker
+        ChunkDescriptor descriptor;
+        bool taken = takeDescriptor(id, &workQueues[id], false, &descriptor);
+        for (int i = 1; !taken && i < numberOfWorkers; i++)
+        {
+            int victim = (id + i) % numberOfWorkers;
+            if ((taken = takeDescriptor(id, &workQueues[victim], true, &descriptor)))
+                workQueues[id].steals++;
+        }
+
+        //descriptors are never added, so every deque is empty
+        if (!taken)
+            return false;
+
+        FileHandler handler = &handlers[descriptor.fileIdx];
+
+        //both ends move to right after the next delimiter, as in sm_claimChunk
+        size_t begin = descriptor.begin;
+        if (begin > 0)
+            begin = findChunkEnd(handler->text, handler->fileSize, begin);
+        size_t end = findChunkEnd(handler->text, handler->fileSize, descriptor.end);
+        if (begin >= end) //the whole range is inside a single word
+            continue;
+
+        *fileHandler = handler;
+        *data = handler->text + begin;
+        *size = end - begin;
+        return true;
+    }
+}
+
+void sm_registerResult(int id, FileHandler fileHandler, Count *count)
+{
+    WorkerResults *results = getWorkerResults(id);
+    Count *fileCount = &results->counts[fileHandler - handlers];
+
+    fileCount->words += count->words;
+    fileCount->wordsBeginningInVowel += count->wordsBeginningInVowel;
+    fileCount->wordsEndingInConsoant += count->wordsEndingInConsoant;
+    results->registrations++;
+}
+
 void sm_getResults(Results *results)
 {
+    //merge the results of every worker
+    for (int id = 0; id < numberOfWorkers; id++)
+    {
+        WorkerResults *workerResults = getWorkerResults(id);
+        for (int i = 0; i < numberOfFiles; i++)
+        {
+            handlers[i].count.words += workerResults->counts[i].words;
+            handlers[i].count.wordsBeginningInVowel += workerResults->counts[i].wordsBeginningInVowel;
+            handlers[i].count.wordsEndingInConsoant += workerResults->counts[i].wordsEndingInConsoant;
+            workerResults->counts[i] = (Count) {0, 0, 0};
+        }
+    }
+
     for(int i = 0; i < numberOfFiles; i++)
     {
         strcpy(results[i].fileName, handlers[i].fileName);
@@ -12,12 +12,18 @@
  * 
  *  Definition of the operations carried out by the workers:
  *     \li sm_getChunkOfData
+ *     \li sm_getChunkView
+ *     \li sm_claimChunk
+ *     \li sm_getPrefetchedChunk
+ *     \li sm_stealChunk
  *     \li sm_registerResult.
  * 
  *  Definition of the operations carried out by the main thread:
  *     \li sm_initialize
  *     \li sm_close.
  *     \li sm_getResults
+ *     \li sm_getLockAcquisitionsAvoided
+ *     \li sm_getStolenChunks
  * 
  *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
  */
@@ -28,6 +34,16 @@
 /** \brief Operation failure return code */
 #define FAILURE 0
 
+/** \brief Sources of the chunks of data given to the workers */
+enum ChunkSource
+{
+    READ_SOURCE,    /*!< Chunks are read from the file streams into the worker's buffer, works on pipes */
+    MMAP_SOURCE,    /*!< Files are memory mapped once, chunks are views of the mappings */
+    ATOMIC_SOURCE,  /*!< Files are memory mapped once, chunks are claimed without entering the monitor */
+    PREFETCH_SOURCE,/*!< A reader thread reads the files ahead of the workers into a ring of buffers */
+    STEALING_SOURCE /*!< Files are memory mapped once, chunks are dealt to per worker deques and stolen when idle */
+};
+
 /** \brief Opaque FileHandler used by workers to identify the target file */
 typedef struct sFileHandler *FileHandler;
 
@@ -54,38 +70,138 @@ typedef struct sResults Results;
  *  This function initializes shared memory resources and it must be called before calling any other
  *  shared memory function.
  *
+ *  When chunkSize is 0 the chunk size is auto-tuned: the total input size is split in about
+ *  AUTO_CHUNKS_PER_WORKER chunks per worker, bounded by MIN_DATA_BUFFER_SIZE and MAX_AUTO_DATA_BUFFER_SIZE.
+ *
+ *  The file name STDIN_FILE_NAME stands for the standard input, which is only supported by READ_SOURCE.
+ *
  *  \param nFiles Total number of files
  *  \param files Array containing the names of all files
+ *  \param source Source of the chunks of data
+ *  \param nWorkers Number of worker threads
+ *  \param chunkSize Size of the chunks of data, 0 to auto-tune it
+ *  \param prefetchDepth Number of chunks read ahead of the workers (PREFETCH_SOURCE)
  *
  *  \returns FAILURE If an error occurs, otherwise SUCCESS
  *  \sa FAILURE
  *  \sa SUCCESS
  *  \sa MAX_FILE_NAME_SIZE
  */
-int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE]);
+int sm_initialize(int nFiles, char files[nFiles][MAX_FILE_NAME_SIZE], enum ChunkSource source, int nWorkers, unsigned int chunkSize,
+                  unsigned int prefetchDepth);
+
+/** \brief Size of the chunks of data
+ *
+ *  \returns size in bytes of the chunks of data, as given to sm_initialize or auto-tuned
+ */
+unsigned int sm_getChunkSize();
 
 /** \brief retrieves a new chunk of data.
  *  
  *  Operation carried out by worker thread.
  *  Then calling this function the worker is given and fileHandler identifying the working file. The size
- *  of the chunk of data is always less or equal then DATA_BUFFER_SIZE. If there's no more text to process
+ *  of the chunk of data is always less or equal then the chunk size. If there's no more text to process
  *  no chunk of data is retrieved and this function returns false, the thread might end is execution.
  *
+ *  The file streams are only read forward: the bytes after the last delimiter of the buffer are kept in
+ *  the file handler and begin the next chunk of data of the same file, so pipes and the standard input
+ *  can be processed. A chunk of data without any delimiter is given whole.
+ *
+ *  \param id Worker thread id
+ *  \param[out] data Buffer containing the chunk of Data, with room for sm_getChunkSize bytes
+ *  \param[out] size The size of the chunk of Data
+ *  \param[out] fileHandler Target processing file handler
+ *
+ *  \returns true If a new chunk was retrieve, otherwise false
+ *
+ *  \sa sm_getChunkSize
+ */
+bool sm_getChunkOfData(int id, unsigned char *data, unsigned int *size, FileHandler *fileHandler);
+
+/** \brief retrieves a view of a new chunk of data.
+ *  
+ *  Operation carried out by worker thread, shared memory must be initialized with MMAP_SOURCE.
+ *  The chunk of data is not copied, the worker is given a pointer into the memory mapped file. The chunk
+ *  spans about sm_getChunkSize bytes and always ends after a delimiter or at the end of the file. Only
+ *  the claim of the next sm_getChunkSize bytes is done inside the monitor, the ends of the chunk are
+ *  aligned to the delimiters outside of it, so the page faults of the scan are not serialized. If there's no more text to process this
+ *  function returns false, the thread might end is execution.
+ *
+ *  \param id Worker thread id
+ *  \param[out] data Pointer to the beginning of the chunk of data
+ *  \param[out] size The size of the chunk of Data
+ *  \param[out] fileHandler Target processing file handler
+ *
+ *  \returns true If a new chunk was retrieve, otherwise false
+ *
+ *  \sa sm_getChunkSize
+ */
+bool sm_getChunkView(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler);
+
+/** \brief claims a view of a new chunk of data without entering the monitor.
+ *  
+ *  Operation carried out by worker thread, shared memory must be initialized with ATOMIC_SOURCE.
+ *  All files are laid out as one logical stream, each file starting at a multiple of the chunk size.
+ *  The worker claims the next chunk size bytes of the stream with an atomic fetch-add and then
+ *  moves both ends of its range forward, to right after the next delimiter, so that the chunks of
+ *  neighbouring claims neither overlap nor leave gaps. If there's no more text to process this function
+ *  returns false, the thread might end is execution.
+ *
  *  \param id Worker thread id
- *  \param[out] data Buffer containing the chunk of Data
+ *  \param[out] data Pointer to the beginning of the chunk of data
  *  \param[out] size The size of the chunk of Data
  *  \param[out] fileHandler Target processing file handler
  *
  *  \returns true If a new chunk was retrieve, otherwise false
  *
- *  \sa DATA_BUFFER_SIZE
+ *  \sa sm_getChunkSize
  */
-bool sm_getChunkOfData(int id, unsigned char data[DATA_BUFFER_SIZE], unsigned int *size, FileHandler *fileHandler);
+bool sm_claimChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler);
+
+/** \brief retrieves a chunk of data read ahead by the reader thread.
+ *  
+ *  Operation carried out by worker thread, shared memory must be initialized with PREFETCH_SOURCE.
+ *  The buffer of the worker's previous chunk is given back to the reader, then the worker waits for
+ *  the next ready chunk. Chunks always end after a delimiter or at the end of the file. If there's no
+ *  more text to process this function returns false, the thread might end is execution.
+ *
+ *  \param id Worker thread id
+ *  \param[out] data Pointer to the beginning of the chunk of data
+ *  \param[out] size The size of the chunk of Data
+ *  \param[out] fileHandler Target processing file handler
+ *
+ *  \returns true If a new chunk was retrieve, otherwise false
+ *
+ *  \sa sm_getChunkSize
+ */
+bool sm_getPrefetchedChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler);
+
+/** \brief takes a view of a chunk of data from the worker's deque or from another worker's deque.
+ *  
+ *  Operation carried out by worker thread, shared memory must be initialized with STEALING_SOURCE.
+ *  At initialization every file is split, from its size, in ranges of sm_getChunkSize bytes which are
+ *  dealt to the workers in contiguous runs. The worker pops ranges from the bottom of its own deque and,
+ *  once it is empty, steals them from the top of the other workers' deques. Each deque has its own lock.
+ *  Both ends of the range are moved forward to right after the next delimiter, as in sm_claimChunk. If
+ *  every deque is empty this function returns false, the thread might end is execution.
+ *
+ *  \param id Worker thread id
+ *  \param[out] data Pointer to the beginning of the chunk of data
+ *  \param[out] size The size of the chunk of Data
+ *  \param[out] fileHandler Target processing file handler
+ *
+ *  \returns true If a new chunk was retrieve, otherwise false
+ *
+ *  \sa sm_getChunkSize
+ */
+bool sm_stealChunk(int id, const unsigned char **data, unsigned int *size, FileHandler *fileHandler);
 
 /** \brief Registers the results of a file's chunk of data
  *  
  *  Operation carried out by worker thread.
  *  After processing a chunk of data the worker calls this function to register the results.
+ *  The results are added to the worker's own counters, without entering the monitor, and are
+ *  only merged by sm_getResults.
  * 
  *  \param id Worker thread id
  *  \param fileHandler Target processing file handler
@@ -95,12 +211,29 @@ void sm_registerResult(int id, FileHandler fileHandler, Count *count);
 
 /** \brief Retrieve final results
  * 
- *  Operation carried out by main thread
+ *  Operation carried out by main thread, after all workers have terminated.
+ *  The counting results of every worker are merged into the results of each file.
  * 
  *  \param[out] results Array containing the results of each file 
  */
 void sm_getResults(Results *results);
 
+/** \brief Number of monitor entries avoided by registering results in per worker counters
+ * 
+ *  Operation carried out by main thread, after all workers have terminated.
+ * 
+ *  \returns number of registered chunks of data
+ */
+unsigned long sm_getLockAcquisitionsAvoided();
+
+/** \brief Number of chunks of data taken from other workers' deques
+ * 
+ *  Operation carried out by main thread, after all workers have terminated.
+ * 
+ *  \returns number of stolen chunks, 0 unless shared memory was initialized with STEALING_SOURCE
+ */
+unsigned long sm_getStolenChunks();
+
 /** \brief Close shared memory
  * 
  *  Operation carried out by main thread
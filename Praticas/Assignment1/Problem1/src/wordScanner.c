@@ -0,0 +1,315 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include "wordScanner.h"
+#include "utf8.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCAN_X86
+#endif
+
+/**
+ *  \file wordScanner.c
+ *
+ *  \brief Word counting scanner implementation
+ *
+ *  A word begins on a vowel, consoant, digit or underscore found outside of a word and ends on the
+ *  next delimiter. Characters of any other type neither begin nor end a word.
+ *
+ *  For a block of ASCII characters the vector kernels build one bit mask per character class and
+ *  solve the "inside a word" recurrence for all the block at once: the state before each character
+ *  is the carry of the addition (pass | set) + set + carryIn, where set are the characters that
+ *  switch the state on and pass the characters that keep it. The same recurrence tracks whether the
+ *  last classified character was a consoant.
+ *
+ *  The ASCII delimiters, vowels and letters tested by the vector kernels are the ones classified
+ *  by utf8.c.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Word counting state carried between characters */
+struct sScanState
+{
+    bool inWord;                        /*!< Inside a word */
+    bool lastIsConsoant;                /*!< Last classified character was a consoant */
+    unsigned int words;                 /*!< Total number of words */
+    unsigned int wordsBeginningInVowel; /*!< Number of words beginning in vowel */
+    unsigned int wordsEndingInConsoant; /*!< Number of words ending in consoant */
+};
+typedef struct sScanState ScanState;
+
+/** \brief Vector kernel, processes whole blocks and returns the number of bytes consumed */
+typedef unsigned int (*ScanKernel)(const unsigned char *data, unsigned int size, ScanState *state);
+
+/** \brief Kernel selected for the running CPU */
+static ScanKernel kernel;
+
+/** \brief Name of the kernel selected for the running CPU */
+static const char *kernelName = "scalar";
+
+/** \brief Processes the character starting at data[0]
+ *
+ *  \param data text
+ *  \param size number of available bytes
+ *  \param state word counting state
+ *
+ *  \returns number of bytes consumed
+ */
+static inline unsigned int scalarStep(const unsigned char *data, unsigned int size, ScanState *state)
+{
+    unsigned int utf8CharSize = getUTF8CharSize(data[0]);
+    if (utf8CharSize == 0) // invalid first byte
+        utf8CharSize = 1;
+    if (utf8CharSize > size) // truncated character
+        utf8CharSize = size;
+
+    unsigned int utf8Char = data[0];
+    for (unsigned int i = 1; i < utf8CharSize; i++)
+        utf8Char = (utf8Char << 8) | data[i];
+
+    enum CharacterType charType = getUTF8CharType(utf8Char);
+
+    if (!state->inWord)
+    {
+        switch (charType)
+        {
+        case VOWEL:
+            state->wordsBeginningInVowel++;
+        case CONSOANT:
+        case UNDERSCORE:
+        case DIGIT:
+            state->words++;
+            state->inWord = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+    else if (charType == DELIMITER)
+    {
+        if (state->lastIsConsoant)
+            state->wordsEndingInConsoant++;
+        state->inWord = false;
+    }
+
+    if (charType != NOT_DEFINED) // ignore case NOT_DEFINED
+        state->lastIsConsoant = (charType == CONSOANT);
+
+    return utf8CharSize;
+}
+
+#ifdef SCAN_X86
+
+/** \brief Updates the word counting state with the class masks of n ASCII characters
+ *
+ *  Bit i of each mask refers to the i-th character, all masks must be zero from bit n onwards.
+ *
+ *  \param state word counting state
+ *  \param word characters that may begin a word (vowels, consoants, digits and underscore)
+ *  \param vowel vowels
+ *  \param consoant consoants
+ *  \param delimiter delimiters
+ *  \param classified characters of a defined type (word, delimiter and apostrophe)
+ *  \param n number of characters
+ */
+static inline void applyMasks(ScanState *state, uint64_t word, uint64_t vowel, uint64_t consoant,
+                              uint64_t delimiter, uint64_t classified, unsigned int n)
+{
+    uint64_t all = (n == 64) ? ~0ULL : ((1ULL << n) - 1);
+
+    // state before each character
+    uint64_t keep = ~(word | delimiter) & all;
+    uint64_t sum = (keep | word) + word + state->inWord;
+    uint64_t inWordBefore = (sum ^ keep) & all;
+
+    // last classified character before each character
+    uint64_t unclassified = ~classified & all;
+    uint64_t sumConsoant = (unclassified | consoant) + consoant + state->lastIsConsoant;
+    uint64_t consoantBefore = (sumConsoant ^ unclassified) & all;
+
+    uint64_t begins = word & ~inWordBefore;
+    uint64_t ends = delimiter & inWordBefore;
+
+    state->words += __builtin_popcountll(begins);
+    state->wordsBeginningInVowel += __builtin_popcountll(begins & vowel);
+    state->wordsEndingInConsoant += __builtin_popcountll(ends & consoantBefore);
+
+    state->inWord = (sum >> n) & 1;
+    state->lastIsConsoant = (sumConsoant >> n) & 1;
+}
+
+/** \brief SSE2 kernel, 16 bytes per step */
+static unsigned int scanSSE2(const unsigned char *data, unsigned int size, ScanState *state)
+{
+    unsigned int idx = 0;
+    while (idx + 16 <= size)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i *) (data + idx));
+        unsigned int nonAscii = (unsigned int) _mm_movemask_epi8(block);
+        unsigned int n = nonAscii ? __builtin_ctz(nonAscii) : 16;
+
+        if (n > 0)
+        {
+            __m128i lower = _mm_or_si128(block, _mm_set1_epi8(0x20));
+            __m128i letter = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                                           _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+            __m128i vowel = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('a')),
+                                                      _mm_cmpeq_epi8(lower, _mm_set1_epi8('e'))),
+                                         _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(lower, _mm_set1_epi8('i')),
+                                                                   _mm_cmpeq_epi8(lower, _mm_set1_epi8('o'))),
+                                                      _mm_cmpeq_epi8(lower, _mm_set1_epi8('u'))));
+            __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('0' - 1)),
+                                          _mm_cmplt_epi8(block, _mm_set1_epi8('9' + 1)));
+            __m128i underscore = _mm_cmpeq_epi8(block, _mm_set1_epi8(0x5F));
+            __m128i apostrophe = _mm_cmpeq_epi8(block, _mm_set1_epi8(0x27));
+
+            __m128i space = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x20)),
+                                                      _mm_cmpeq_epi8(block, _mm_set1_epi8(0x09))),
+                                         _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x0A)),
+                                                      _mm_cmpeq_epi8(block, _mm_set1_epi8(0x0D))));
+            __m128i separation = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x2D)),
+                                                           _mm_cmpeq_epi8(block, _mm_set1_epi8(0x22))),
+                                              _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x5D)),
+                                                           _mm_cmpeq_epi8(block, _mm_set1_epi8(0x29))));
+            __m128i punctuation = _mm_or_si128(_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x2E)),
+                                                                         _mm_cmpeq_epi8(block, _mm_set1_epi8(0x2C))),
+                                                            _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x3A)),
+                                                                         _mm_cmpeq_epi8(block, _mm_set1_epi8(0x3B)))),
+                                               _mm_or_si128(_mm_cmpeq_epi8(block, _mm_set1_epi8(0x3F)),
+                                                            _mm_cmpeq_epi8(block, _mm_set1_epi8(0x21))));
+
+            uint64_t all = (1ULL << n) - 1;
+            uint64_t letterMask = (unsigned int) _mm_movemask_epi8(letter) & all;
+            uint64_t vowelMask = (unsigned int) _mm_movemask_epi8(vowel) & all;
+            uint64_t wordMask = letterMask | ((unsigned int) _mm_movemask_epi8(_mm_or_si128(digit, underscore)) & all);
+            uint64_t delimiterMask = (unsigned int) _mm_movemask_epi8(_mm_or_si128(_mm_or_si128(space, separation), punctuation)) & all;
+            uint64_t apostropheMask = (unsigned int) _mm_movemask_epi8(apostrophe) & all;
+
+            applyMasks(state, wordMask, vowelMask, letterMask & ~vowelMask, delimiterMask,
+                       wordMask | delimiterMask | apostropheMask, n);
+            idx += n;
+        }
+
+        if (nonAscii)
+            idx += scalarStep(data + idx, size - idx, state);
+    }
+    return idx;
+}
+
+/** \brief AVX2 kernel, 32 bytes per step */
+__attribute__((target("avx2"))) static unsigned int scanAVX2(const unsigned char *data, unsigned int size, ScanState *state)
+{
+    unsigned int idx = 0;
+    while (idx + 32 <= size)
+    {
+        __m256i block = _mm256_loadu_si256((const __m256i *) (data + idx));
+        unsigned int nonAscii = (unsigned int) _mm256_movemask_epi8(block);
+        unsigned int n = nonAscii ? __builtin_ctz(nonAscii) : 32;
+
+        if (n > 0)
+        {
+            __m256i lower = _mm256_or_si256(block, _mm256_set1_epi8(0x20));
+            __m256i letter = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)),
+                                              _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+            __m256i vowel = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('a')),
+                                                            _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('e'))),
+                                            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(lower, _mm256_set1_epi8('i')),
+                                                                            _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('o'))),
+                                                            _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('u'))));
+            __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('0' - 1)),
+                                             _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), block));
+            __m256i underscore = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x5F));
+            __m256i apostrophe = _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x27));
+
+            __m256i space = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x20)),
+                                                            _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x09))),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x0A)),
+                                                            _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x0D))));
+            __m256i separation = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x2D)),
+                                                                 _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x22))),
+                                                 _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x5D)),
+                                                                 _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x29))));
+            __m256i punctuation = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x2E)),
+                                                                                  _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x2C))),
+                                                                  _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x3A)),
+                                                                                  _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x3B)))),
+                                                  _mm256_or_si256(_mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x3F)),
+                                                                  _mm256_cmpeq_epi8(block, _mm256_set1_epi8(0x21))));
+
+            uint64_t all = (1ULL << n) - 1;
+            uint64_t letterMask = (unsigned int) _mm256_movemask_epi8(letter) & all;
+            uint64_t vowelMask = (unsigned int) _mm256_movemask_epi8(vowel) & all;
+            uint64_t wordMask = letterMask | ((unsigned int) _mm256_movemask_epi8(_mm256_or_si256(digit, underscore)) & all);
+            uint64_t delimiterMask = (unsigned int) _mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(space, separation), punctuation)) & all;
+            uint64_t apostropheMask = (unsigned int) _mm256_movemask_epi8(apostrophe) & all;
+
+            applyMasks(state, wordMask, vowelMask, letterMask & ~vowelMask, delimiterMask,
+                       wordMask | delimiterMask | apostropheMask, n);
+            idx += n;
+        }
+
+        if (nonAscii)
+            idx += scalarStep(data + idx, size - idx, state);
+    }
+
+    // remaining 16 bytes blocks
+    return idx + scanSSE2(data + idx, size - idx, state);
+}
+
+#endif /* SCAN_X86 */
+
+/** \brief Selects the kernel for the running CPU at program startup */
+__attribute__((constructor)) static void selectKernel(void)
+{
+#ifdef SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        kernel = scanAVX2;
+        kernelName = "avx2";
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        kernel = scanSSE2;
+        kernelName = "sse2";
+    }
+#endif
+}
+
+void scanChunk(const unsigned char *data, unsigned int size, unsigned int *words,
+               unsigned int *wordsBeginningInVowel, unsigned int *wordsEndingInConsoant)
+{
+    ScanState state = {false, false, 0, 0, 0};
+    unsigned int dataIdx = 0;
+
+    if (kernel != NULL)
+        dataIdx = kernel(data, size, &state);
+
+    while (dataIdx < size)
+        dataIdx += scalarStep(data + dataIdx, size - dataIdx, &state);
+
+    *words = state.words;
+    *wordsBeginningInVowel = state.wordsBeginningInVowel;
+    *wordsEndingInConsoant = state.wordsEndingInConsoant;
+}
+
+void scanChunkScalar(const unsigned char *data, unsigned int size, unsigned int *words,
+                     unsigned int *wordsBeginningInVowel, unsigned int *wordsEndingInConsoant)
+{
+    ScanState state = {false, false, 0, 0, 0};
+    unsigned int dataIdx = 0;
+
+    while (dataIdx < size)
+        dataIdx += scalarStep(data + dataIdx, size - dataIdx, &state);
+
+    *words = state.words;
+    *wordsBeginningInVowel = state.wordsBeginningInVowel;
+    *wordsEndingInConsoant = state.wordsEndingInConsoant;
+}
+
+const char *scanKernelName()
+{
+    return kernelName;
+}
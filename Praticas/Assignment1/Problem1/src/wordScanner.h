@@ -0,0 +1,48 @@
+#ifndef WORD_SCANNER_H
+#define WORD_SCANNER_H
+
+/**
+ *  \file wordScanner.h
+ *
+ *  \brief Word counting scanner header
+ *
+ *  Counts the words of a chunk of utf8 text. ASCII text is classified 16 (SSE2) or 32 (AVX2) bytes
+ *  at a time, only characters with a byte greater or equal than 0x80 go through the scalar utf8 path.
+ *  The vector kernel is selected at program startup according to the features of the running CPU.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Counts the words of a chunk of text
+ *
+ *  The chunk is expected to start outside of a word, i.e., at the beginning of the text or after a delimiter.
+ *
+ *  \param data chunk of text
+ *  \param size size of the chunk of text
+ *  \param[out] words total number of words
+ *  \param[out] wordsBeginningInVowel number of words beginning in vowel
+ *  \param[out] wordsEndingInConsoant number of words ending in consoant
+ */
+void scanChunk(const unsigned char *data, unsigned int size, unsigned int *words,
+               unsigned int *wordsBeginningInVowel, unsigned int *wordsEndingInConsoant);
+
+/** \brief Counts the words of a chunk of text one character at a time
+ *
+ *  Reference implementation of scanChunk, the results are always the same.
+ *
+ *  \param data chunk of text
+ *  \param size size of the chunk of text
+ *  \param[out] words total number of words
+ *  \param[out] wordsBeginningInVowel number of words beginning in vowel
+ *  \param[out] wordsEndingInConsoant number of words ending in consoant
+ */
+void scanChunkScalar(const unsigned char *data, unsigned int size, unsigned int *words,
+                     unsigned int *wordsBeginningInVowel, unsigned int *wordsEndingInConsoant);
+
+/** \brief Name of the kernel selected for the running CPU
+ *
+ *  \returns "avx2", "sse2" or "scalar"
+ */
+const char *scanKernelName();
+
+#endif /* WORD_SCANNER_H */
@@ -0,0 +1,54 @@
+#define _GNU_SOURCE
+#include <sched.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "affinity.h"
+
+
+/** \brief processors the program may run on, in increasing order */
+static int cpus[CPU_SETSIZE];
+
+/** \brief number of processors the program may run on, 0 while pinning is disabled */
+static unsigned int nCpus = 0;
+
+
+bool affinity_init() {
+    cpu_set_t allowed;
+    if(sched_getaffinity(0, sizeof(cpu_set_t), &allowed) != 0) {
+        return false;
+    }
+
+    nCpus = 0;
+    for(int cpu=0;cpu<CPU_SETSIZE;cpu++) {
+        if(CPU_ISSET(cpu, &allowed)) {
+            cpus[nCpus++] = cpu;
+        }
+    }
+    return nCpus > 0;
+}
+
+bool affinity_set(pthread_attr_t * attr, unsigned int slot) {
+    if(nCpus == 0) {
+        return false;
+    }
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpus[slot % nCpus], &set);
+    return pthread_attr_setaffinity_np(attr, sizeof(cpu_set_t), &set) == 0;
+}
+
+int affinity_slot() {
+    cpu_set_t set;
+    if(nCpus == 0 || pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &set) != 0 || CPU_COUNT(&set) != 1) {
+        return -1;
+    }
+
+    for(int i=0;i<nCpus;i++) {
+        if(CPU_ISSET(cpus[i], &set)) {
+            return i;
+        }
+    }
+    return -1;
+}
@@ -0,0 +1,47 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <stdbool.h>
+#include <pthread.h>
+
+/**
+ *  \file affinity.h
+ *
+ *  \brief Pinning of the threads to processors
+ *
+ *  Threads are pinned by slot: slot i goes to the i-th processor the program may run on, wrapping
+ *  around when there are more slots than processors. The computing workers take the first slots and
+ *  the readers the following ones. A team of threads started by a pinned computing worker takes the
+ *  slots after the one of its leader, those of the workers left idle by the team.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+
+/** \brief Enables pinning
+ *
+ *  Takes the processors the program may run on, to be called by the main thread before starting any
+ *  thread. Without it threads are not pinned.
+ *
+ *  \returns true if pinning is enabled, false if the processors could not be found
+*/
+bool affinity_init();
+
+
+/** \brief Pins the thread to be created with the given attributes
+ *
+ *  \param attr attributes of the thread to be created
+ *  \param slot slot of the thread
+ *
+ *  \returns true if the thread will be pinned, false if pinning is disabled or failed
+*/
+bool affinity_set(pthread_attr_t * attr, unsigned int slot);
+
+
+/** \brief Slot of the calling thread
+ *
+ *  \returns slot of the processor the calling thread is pinned to, -1 if it is not pinned
+*/
+int affinity_slot();
+
+#endif /* AFFINITY_H */
@@ -0,0 +1,11 @@
+gcc bench/matrix_bench.c matrix.c -Wall -O3 -lm -o matrix_bench
+./matrix_bench
+gcc bench/lu_bench.c matrix.c lu_determinant.c -Wall -O3 -lm -o lu_bench
+[ $# -gt 0 ] && ./lu_bench "$@"
+gcc bench/fifo_bench.c fifo.c -Wall -O3 -lpthread -o fifo_bench
+gcc bench/fifo_bench.c fifo_monitor.c -DFIFO_MONITOR -Wall -O3 -lpthread -o fifo_bench_monitor
+./fifo_bench 1 && ./fifo_bench_monitor 1
+./fifo_bench && ./fifo_bench_monitor
+./fifo_bench 8 2000000 0 32 && ./fifo_bench_monitor 8 2000000 0 32
+gcc bench/team_bench.c matrix.c lu_determinant.c determinant_team.c affinity.c -Wall -O3 -lpthread -lm -o team_bench
+./team_bench 2048
@@ -0,0 +1,136 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "../fifo.h"
+#include "../constants.h"
+
+/**
+ *  \file fifo_bench.c
+ *
+ *  \brief Fifo contention microbenchmark
+ *
+ *  N_FILE_READER_WORKERS producers put a given number of values in the fifo and a given number of
+ *  consumers get them, optionally spinning for a while on each value to
+ *  mimic the determinant of a small matrix. Values are moved in batches of the given size (1 by
+ *  default) through putMatrices / getMatrices. Built against fifo.c (lock-free) or, with
+ *  -DFIFO_MONITOR, against fifo_monitor.c, so that both fifos can be compared.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief producer threads return status array */
+int * statusProd;
+
+/** \brief consumer threads return status array */
+int * statusCons;
+
+/** \brief number of values put by each producer */
+static unsigned long nValues;
+
+/** \brief work units done by a consumer on each value */
+static unsigned int workPerValue;
+
+/** \brief number of values moved at once */
+static unsigned int batchSize;
+
+/** \brief values put in the fifo, their content is not used */
+static MatrixHandler handler;
+
+/** \brief values retrieved by each consumer */
+static unsigned long * retrieved;
+
+/** \brief Gets the elapsed time in seconds between two instants */
+static double elapsed(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) / 1.0 + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/** \brief Producer routine */
+static void * produce(void * arg) {
+    unsigned int id = *((unsigned int*) arg);
+    MatrixHandler * batch[batchSize];
+    for(unsigned int i=0;i<batchSize;i++) {
+        batch[i] = &handler;
+    }
+    for(unsigned long i=0;i<nValues;i+=batchSize) {
+        putMatrices(id, batch, (nValues - i < batchSize) ? nValues - i : batchSize);
+    }
+    return NULL;
+}
+
+/** \brief Consumer routine */
+static void * consume(void * arg) {
+    unsigned int id = *((unsigned int*) arg);
+    MatrixHandler * batch[batchSize];
+    volatile double sink = 1;
+    unsigned int n;
+    while((n = getMatrices(id, batch, batchSize)) > 0) {
+        for(unsigned int w=0;w<workPerValue*n;w++) {
+            sink = sink * 1.0000001;
+        }
+        retrieved[id] += n;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int nConsumers = argc > 1 ? atoi(argv[1]) : N_DETERMINANT_WORKERS;
+    nValues = argc > 2 ? atol(argv[2]) : 2000000;
+    workPerValue = argc > 3 ? atoi(argv[3]) : 0;
+    batchSize = argc > 4 ? atoi(argv[4]) : 1;
+    if(nConsumers < 1 || batchSize < 1 || batchSize > MAX_BATCH_SIZE) {
+        fprintf(stderr, "USAGE: ./fifo_bench [consumers] [values per producer] [work per value] [batch size (1-%d)]\n",
+                MAX_BATCH_SIZE);
+        return EXIT_FAILURE;
+    }
+    statusProd = (int*) malloc(N_FILE_READER_WORKERS * sizeof(int));
+    statusCons = (int*) malloc(nConsumers * sizeof(int));
+    retrieved = (unsigned long*) calloc(nConsumers, sizeof(unsigned long));
+
+    pthread_t producers[N_FILE_READER_WORKERS], consumers[nConsumers];
+    unsigned int producerIds[N_FILE_READER_WORKERS], consumerIds[nConsumers];
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for(unsigned int i=0;i<nConsumers;i++) {
+        consumerIds[i] = i;
+        pthread_create(&consumers[i], NULL, consume, &consumerIds[i]);
+    }
+    for(unsigned int i=0;i<N_FILE_READER_WORKERS;i++) {
+        producerIds[i] = i;
+        pthread_create(&producers[i], NULL, produce, &producerIds[i]);
+    }
+
+    for(unsigned int i=0;i<N_FILE_READER_WORKERS;i++) {
+        pthread_join(producers[i], NULL);
+    }
+    doneReading();
+    for(unsigned int i=0;i<nConsumers;i++) {
+        pthread_join(consumers[i], NULL);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    unsigned long total = 0;
+    for(unsigned int i=0;i<nConsumers;i++) {
+        total += retrieved[i];
+    }
+    if(total != nValues * N_FILE_READER_WORKERS) {
+        fprintf(stderr, "Lost values: %lu of %lu retrieved\n", total, nValues * N_FILE_READER_WORKERS);
+        return EXIT_FAILURE;
+    }
+
+#ifdef FIFO_MONITOR
+    const char * name = "monitor";
+#else
+    const char * name = "lock-free";
+#endif
+    double time = elapsed(start, end);
+    printf("%-9s producers %d consumers %u values %lu work %u batch %u: %.6f s, %.2f Mvalues/s\n", name,
+           N_FILE_READER_WORKERS, nConsumers, total, workPerValue, batchSize, time, total / time / 1e6);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../matrix.h"
+#include "../lu_determinant.h"
+
+/**
+ *  \file lu_bench.c
+ *
+ *  \brief Determinant kernels benchmark
+ *
+ *  Computes the determinants of every matrix of the given binary matrix files with the gaussian
+ *  elimination kernel and with the blocked LU kernel. For each file, prints the time and GFLOP/s
+ *  (2/3 n^3 flops per matrix) of both kernels and their maximum and mean relative error against a
+ *  long double LU with partial pivoting. Matrices whose reference determinant is 0 are only counted.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Gets the elapsed time in seconds between two instants */
+static double elapsed(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) / 1.0 + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/** \brief Reference determinant, long double LU with partial pivoting */
+static long double reference_determinant(const double * numbers, unsigned int order) {
+    long double * a = (long double*) malloc(sizeof(long double) * order * order);
+    for(size_t i=0;i<(size_t) order * order;i++) {
+        a[i] = numbers[i];
+    }
+
+    long double determinant = 1;
+    for(unsigned int j=0;j<order && determinant != 0;j++) {
+        unsigned int pivot = j;
+        for(unsigned int i=j+1;i<order;i++) {
+            if(fabsl(a[i * order + j]) > fabsl(a[pivot * order + j])) {
+                pivot = i;
+            }
+        }
+        if(pivot != j) {
+            for(unsigned int c=0;c<order;c++) {
+                long double aux = a[j * order + c];
+                a[j * order + c] = a[pivot * order + c];
+                a[pivot * order + c] = aux;
+            }
+            determinant = -determinant;
+        }
+        determinant *= a[j * order + j];
+        if(a[j * order + j] == 0) {
+            break;
+        }
+        for(unsigned int i=j+1;i<order;i++) {
+            long double l = a[i * order + j] / a[j * order + j];
+            for(unsigned int c=j+1;c<order;c++) {
+                a[i * order + c] -= l * a[j * order + c];
+            }
+        }
+    }
+
+    free(a);
+    return determinant;
+}
+
+/** \brief Relative error of a determinant, the reference is not 0 */
+static double relative_error(double value, long double reference) {
+    return (double) fabsl((value - reference) / reference);
+}
+
+/** \brief Benchmarks both kernels on a file
+ *
+ *  \param fileName binary matrix file
+ *  \param iterations number of times each kernel computes every matrix
+ *
+ *  \returns 0 on success, -1 otherwise
+ */
+static int run(const char * fileName, unsigned int iterations) {
+    FILE * ptrFile = fopen(fileName, "rb");
+    if(ptrFile == NULL) {
+        perror("Error opening file");
+        return -1;
+    }
+
+    unsigned int nMatrices, order;
+    if(fread(&nMatrices, sizeof(unsigned int), 1, ptrFile) != 1 || fread(&order, sizeof(unsigned int), 1, ptrFile) != 1) {
+        fprintf(stderr, "Error reading header of %s\n", fileName);
+        fclose(ptrFile);
+        return -1;
+    }
+
+    size_t matrixSize = (size_t) order * order;
+    double * source = (double*) malloc(sizeof(double) * matrixSize * nMatrices);
+    if(fread(source, sizeof(double), matrixSize * nMatrices, ptrFile) != matrixSize * nMatrices) {
+        fprintf(stderr, "Error reading matrices of %s\n", fileName);
+        free(source);
+        fclose(ptrFile);
+        return -1;
+    }
+    fclose(ptrFile);
+
+    Matrix * matrix = alloc_matrix(order);
+    double time[2] = {0, 0}, maxError[2] = {0, 0}, sumError[2] = {0, 0};
+    unsigned int nSingular = 0;
+    for(int m=0;m<nMatrices;m++) {
+        long double reference = reference_determinant(source + m * matrixSize, order);
+        if(reference == 0) {
+            nSingular++;
+        }
+
+        for(int kernel=0;kernel<2;kernel++) {
+            double determinant = 0;
+            for(int it=0;it<iterations;it++) {
+                memcpy(matrix->numbers, source + m * matrixSize, sizeof(double) * matrixSize);
+
+                struct timespec start, end;
+                clock_gettime(CLOCK_MONOTONIC, &start);
+                determinant = (kernel == 0) ? compute_determinant(*matrix) : compute_determinant_lu(*matrix);
+                clock_gettime(CLOCK_MONOTONIC, &end);
+                time[kernel] += elapsed(start, end);
+            }
+
+            if(reference == 0) {
+                continue;
+            }
+            double error = relative_error(determinant, reference);
+            sumError[kernel] += error;
+            if(error > maxError[kernel]) {
+                maxError[kernel] = error;
+            }
+        }
+    }
+    free_matrix(matrix);
+    free(source);
+
+    double flops = 2.0 / 3.0 * order * order * order * nMatrices * iterations;
+    printf("File %s: %u matrices of order %u (%u singular)\n", fileName, nMatrices, order, nSingular);
+    unsigned int nRegular = (nMatrices > nSingular) ? nMatrices - nSingular : 1;
+    const char * names[2] = {"gauss", "lu"};
+    for(int kernel=0;kernel<2;kernel++) {
+        printf("  %-6s %10.6f s  %7.3f GFLOP/s  max rel. error %.3e  mean rel. error %.3e\n", names[kernel],
+               time[kernel] / iterations, flops / time[kernel] / 1e9, maxError[kernel], sumError[kernel] / nRegular);
+    }
+    printf("  speedup %.2fx\n", time[0] / time[1]);
+
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if(argc == 1) {
+        fprintf(stderr, "USAGE: ./lu_bench [-i iterations] fileName [fileName ...]\n");
+        return EXIT_FAILURE;
+    }
+
+    unsigned int iterations = 5;
+    int first = 1;
+    if(strcmp(argv[1], "-i") == 0 && argc > 2) {
+        iterations = atoi(argv[2]);
+        first = 3;
+    }
+
+    printf("LU trailing update kernel: %s\n", lu_kernel_name());
+    for(int i=first;i<argc;i++) {
+        if(run(argv[i], iterations) != 0) {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
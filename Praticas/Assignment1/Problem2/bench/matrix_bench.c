@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../matrix.h"
+
+/**
+ *  \file matrix_bench.c
+ *
+ *  \brief Matrix storage microbenchmark
+ *
+ *  Compares the former row pointers storage (double **, one malloc per row) with the contiguous
+ *  aligned storage of Matrix. For each order, a batch of random matrices is loaded (allocation and
+ *  copy of the coefficients, as done by the file reader), their determinants are computed and they
+ *  are freed again. The number of distinct 4 KiB pages spanned by the coefficients of a matrix is
+ *  reported as an estimate of the TLB entries needed to sweep it.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief size of a page */
+#define PAGE_SIZE 4096
+
+/** \brief Matrix with one allocation per row, the former storage */
+typedef struct sRowsMatrix {
+    unsigned int order;
+    double ** numbers;
+} RowsMatrix;
+
+/** \brief Gets the elapsed time in seconds between two instants */
+static double elapsed(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) / 1.0 + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/** \brief Former matrix allocation and load, order + 2 mallocs */
+static RowsMatrix * load_rows_matrix(unsigned int order, const double * source) {
+    RowsMatrix * matrix = (RowsMatrix*) malloc(sizeof(RowsMatrix));
+    matrix->order = order;
+    matrix->numbers = (double **) malloc(sizeof(double*)*order);
+    for(int i=0;i<order;i++) {
+        matrix->numbers[i] = (double*) malloc(sizeof(double)*order);
+        memcpy(matrix->numbers[i], source + (size_t) i * order, sizeof(double)*order);
+    }
+    return matrix;
+}
+
+/** \brief Former matrix release */
+static void free_rows_matrix(RowsMatrix * matrix) {
+    for(int i=0;i<matrix->order;i++) {
+        free(matrix->numbers[i]);
+    }
+    free(matrix->numbers);
+    free(matrix);
+}
+
+/** \brief Former determinant computation */
+static double compute_rows_determinant(RowsMatrix matrix) {
+    int sign = 1;
+    double ratio, determinant = 1;
+
+    for(int i=0;i<matrix.order;i++) {
+        if(matrix.numbers[i][i] == 0) {
+            for(int j=i+1;j<matrix.order;j++) {
+                if(matrix.numbers[j][i] != 0) {
+                    for(int k=0;k<matrix.order;k++) {
+                        double aux = matrix.numbers[i][k];
+                        matrix.numbers[i][k] = matrix.numbers[j][k];
+                        matrix.numbers[j][k] = aux;
+                    }
+                    sign = (sign == 1) ? -1: 1;
+                    break;
+                }
+            }
+        }
+
+        // same flops as compute_determinant, only the storage differs
+        for(int j=i+1;j<matrix.order;j++) {
+            ratio = matrix.numbers[j][i]/matrix.numbers[i][i];
+            for(int k=i+1;k<matrix.order;k++) {
+                matrix.numbers[j][k] = matrix.numbers[j][k]-ratio*matrix.numbers[i][k];
+            }
+        }
+        determinant *= matrix.numbers[i][i];
+    }
+
+    return determinant * sign;
+}
+
+/** \brief Counts the distinct pages spanned by the given address ranges */
+static unsigned int count_pages(unsigned int nRanges, char ** begin, size_t length) {
+    unsigned long pages[nRanges * (length / PAGE_SIZE + 2)];
+    unsigned int nPages = 0;
+    for(int i=0;i<nRanges;i++) {
+        for(unsigned long page = (unsigned long) begin[i] / PAGE_SIZE; page <= (unsigned long) (begin[i] + length - 1) / PAGE_SIZE; page++) {
+            bool found = false;
+            for(int j=0;j<nPages && !found;j++) {
+                found = pages[j] == page;
+            }
+            if(!found) {
+                pages[nPages++] = page;
+            }
+        }
+    }
+    return nPages;
+}
+
+/** \brief Runs both storages over a batch of matrices of the given order */
+static int run(unsigned int order, unsigned int nMatrices, unsigned int iterations) {
+    size_t matrixSize = (size_t) order * order;
+    double * source = (double*) malloc(sizeof(double) * matrixSize * nMatrices);
+    for(size_t i=0;i<matrixSize * nMatrices;i++) {
+        source[i] = (double) rand() / RAND_MAX * 2 - 1;
+    }
+
+    RowsMatrix * rowsMatrices[nMatrices];
+    Matrix * matrices[nMatrices];
+    double rowsDeterminants[nMatrices], determinants[nMatrices];
+    double rowsLoad = 0, rowsCompute = 0, rowsFree = 0, load = 0, compute = 0, release = 0;
+    struct timespec t0, t1, t2, t3;
+
+    for(int it=0;it<iterations;it++) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for(int m=0;m<nMatrices;m++) {
+            rowsMatrices[m] = load_rows_matrix(order, source + m * matrixSize);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        for(int m=0;m<nMatrices;m++) {
+            rowsDeterminants[m] = compute_rows_determinant(*rowsMatrices[m]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        for(int m=0;m<nMatrices;m++) {
+            free_rows_matrix(rowsMatrices[m]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t3);
+        rowsLoad += elapsed(t0, t1); rowsCompute += elapsed(t1, t2); rowsFree += elapsed(t2, t3);
+
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for(int m=0;m<nMatrices;m++) {
+            matrices[m] = alloc_matrix(order);
+            memcpy(matrices[m]->numbers, source + m * matrixSize, sizeof(double) * matrixSize);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        for(int m=0;m<nMatrices;m++) {
+            determinants[m] = compute_determinant(*matrices[m]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t2);
+        for(int m=0;m<nMatrices;m++) {
+            free_matrix(matrices[m]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t3);
+        load += elapsed(t0, t1); compute += elapsed(t1, t2); release += elapsed(t2, t3);
+    }
+
+    // both storages must give the same determinants
+    for(int m=0;m<nMatrices;m++) {
+        if(fabs(rowsDeterminants[m] - determinants[m]) > 1e-9 * fabs(rowsDeterminants[m])) {
+            fprintf(stderr, "Determinant mismatch on matrix %d: %.6e != %.6e\n", m, rowsDeterminants[m], determinants[m]);
+            return -1;
+        }
+    }
+
+    // pages spanned by one matrix of each storage
+    RowsMatrix * rowsMatrix = load_rows_matrix(order, source);
+    Matrix * matrix = alloc_matrix(order);
+    unsigned int rowsPages = count_pages(order, (char **) rowsMatrix->numbers, sizeof(double) * order);
+    char * block = (char*) matrix->numbers;
+    unsigned int pages = count_pages(1, &block, sizeof(double) * matrixSize);
+    free_rows_matrix(rowsMatrix);
+    free_matrix(matrix);
+
+    double perMatrix = 1e6 / ((double) nMatrices * iterations);
+    printf("Order %u, %u matrices x %u iterations\n", order, nMatrices, iterations);
+    printf("  %-12s load %9.2f us  determinant %9.2f us  free %7.2f us  mallocs %4u  pages %4u\n", "double **",
+           rowsLoad * perMatrix, rowsCompute * perMatrix, rowsFree * perMatrix, order + 2, rowsPages);
+    printf("  %-12s load %9.2f us  determinant %9.2f us  free %7.2f us  mallocs %4u  pages %4u\n", "contiguous",
+           load * perMatrix, compute * perMatrix, release * perMatrix, 1, pages);
+    printf("  speedup: load %.2fx  determinant %.2fx  total %.2fx\n", rowsLoad / load, rowsCompute / compute,
+           (rowsLoad + rowsCompute + rowsFree) / (load + compute + release));
+
+    free(source);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int iterations = argc > 1 ? atoi(argv[1]) : 10;
+    srand(1);
+
+    if(run(128, 128, iterations) != 0 || run(256, 32, iterations) != 0) {
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "../matrix.h"
+#include "../lu_determinant.h"
+#include "../determinant_team.h"
+
+/**
+ *  \file team_bench.c
+ *
+ *  \brief Team determinant benchmark
+ *
+ *  Computes the determinant of a random matrix of the given order with a single thread and with teams
+ *  of 2 up to the given number of threads, for both kernels. Every team must give the same determinant
+ *  as the single thread, bit for bit. A matrix with zero pivots on its diagonal is checked as well, so
+ *  that the row switches of the gaussian elimination are covered.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Gets the elapsed time in seconds between two instants */
+static double elapsed(struct timespec start, struct timespec end) {
+    return (end.tv_sec - start.tv_sec) / 1.0 + (end.tv_nsec - start.tv_nsec) / 1000000000.0;
+}
+
+/** \brief Computes a copy of the source with the given kernel and team size
+ *
+ *  \param matrix matrix overwritten by the elimination
+ *  \param source coefficients
+ *  \param kernel elimination
+ *  \param teamSize number of threads, 1 for the single thread kernels
+ *  \param[out] time elapsed time
+ *
+ *  \returns determinant
+ */
+static double run(Matrix * matrix, const double * source, enum DeterminantKernel kernel, unsigned int teamSize, double * time) {
+    memcpy(matrix->numbers, source, sizeof(double) * matrix->order * matrix->order);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double determinant;
+    if(teamSize > 1) {
+        determinant = compute_determinant_team(*matrix, kernel, teamSize);
+    }
+    else {
+        determinant = (kernel == LU_KERNEL) ? compute_determinant_lu(*matrix) : compute_determinant(*matrix);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    *time = elapsed(start, end);
+    return determinant;
+}
+
+/** \brief Checks and times every team size on a matrix
+ *
+ *  \returns 0 if every team matches the single thread, -1 otherwise
+ */
+static int check(const char * name, const double * source, unsigned int order, unsigned int maxTeamSize) {
+    Matrix * matrix = alloc_matrix(order);
+    const char * kernels[2] = {"gauss", "lu"};
+    int result = 0;
+
+    printf("%s matrix of order %u\n", name, order);
+    for(int kernel=GAUSS_KERNEL;kernel<=LU_KERNEL;kernel++) {
+        double singleTime, time;
+        double single = run(matrix, source, kernel, 1, &singleTime);
+        printf("  %-5s 1 thread  %9.4f s  determinant %.6e\n", kernels[kernel], singleTime, single);
+
+        for(unsigned int teamSize=2;teamSize<=maxTeamSize;teamSize++) {
+            double determinant = run(matrix, source, kernel, teamSize, &time);
+            bool same = memcmp(&determinant, &single, sizeof(double)) == 0;
+            printf("  %-5s %u threads %9.4f s  speedup %.2fx  %s\n", kernels[kernel], teamSize, time, singleTime / time,
+                   same ? "same determinant" : "DIFFERENT DETERMINANT");
+            if(!same) {
+                result = -1;
+            }
+        }
+    }
+
+    free_matrix(matrix);
+    return result;
+}
+
+int main(int argc, char *argv[]) {
+    unsigned int order = argc > 1 ? atoi(argv[1]) : 1024;
+    unsigned int maxTeamSize = argc > 2 ? atoi(argv[2]) : 8;
+    if(order < 2 || maxTeamSize < 2) {
+        fprintf(stderr, "USAGE: ./team_bench [order (>= 2)] [maximum team size (>= 2)]\n");
+        return EXIT_FAILURE;
+    }
+
+    size_t size = (size_t) order * order;
+    double * source = (double*) malloc(sizeof(double) * size);
+    // scaled so that the determinant stays in range, about sqrt(n!) * (scale / sqrt(3))^n
+    double scale = sqrt(3 * exp(1) / order);
+    srand(1);
+    for(size_t i=0;i<size;i++) {
+        source[i] = ((double) rand() / RAND_MAX * 2 - 1) * scale;
+    }
+    printf("LU trailing update kernel: %s\n", lu_kernel_name());
+    int result = check("Random", source, order, maxTeamSize);
+
+    // permutation of an upper triangle, every pivot of the gaussian elimination is found by a switch
+    for(unsigned int i=0;i<order;i++) {
+        unsigned int row = (i + 1) % order;
+        for(unsigned int j=0;j<order;j++) {
+            source[(size_t) row * order + j] = (j >= i) ? (double) rand() / RAND_MAX + 0.5 : 0;
+        }
+    }
+    result |= check("Zero pivots", source, order, maxTeamSize);
+
+    free(source);
+    return (result == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1 @@
+gcc -Wall -O3 *.c -lpthread -o main
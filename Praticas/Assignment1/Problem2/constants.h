@@ -15,8 +15,22 @@
 
 #define     N_DETERMINANT_WORKERS           8
 
-#define     N_FILE_READER_WORKERS           1
+#define     N_FILE_READER_WORKERS           2
 
-#define     FIFO_MAX_SIZE                   20
+#define     FIFO_MAX_SIZE                   64
+
+/* Batches of matrices */
+
+
+#define     MAX_BATCH_SIZE                  32
+
+#define     BATCH_WORK                      (1 << 20)
+
+#define     BATCHES_PER_READ_RANGE          4
+
+/* Teams of threads computing a single determinant */
+
+
+#define     TEAM_MIN_ORDER                  512
 
 #endif /* CONSTANTS_H */
@@ -1,33 +1,94 @@
 
+#include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "fifo.h"
 #include "matrix.h"
 #include "shared_memory.h"
+#include "lu_determinant.h"
+#include "determinant_team.h"
+#include "determinant_calculation.h"
+#include "constants.h"
 
+/** \brief kernel used to compute the determinants */
+extern enum DeterminantKernel determinantKernel;
+
+/** \brief number of determinant computing threads */
+extern unsigned int nDeterminantWorkers;
+
+
+/** \brief Copies a view of a mapped matrix to the scratch matrix of the thread
+ *
+ *  The scratch matrix is allocated once and only grows when a larger order shows up.
+ *
+ *  \param scratch scratch matrix of the thread, NULL until the first copy
+ *  \param capacity order the scratch matrix was allocated for
+ *  \param view view of the matrix, read-only
+ *
+ *  \returns the scratch matrix holding the copy
+ */
+static Matrix * copy_to_scratch(Matrix ** scratch, unsigned int * capacity, Matrix * view) {
+    if(*scratch == NULL || view->order > *capacity) {
+        free_matrix(*scratch);
+        *scratch = alloc_matrix(view->order);
+        if(*scratch == NULL) {
+            perror("Error allocating scratch matrix");
+            exit(EXIT_FAILURE);
+        }
+        *capacity = view->order;
+    }
+
+    (*scratch)->order = view->order;
+    memcpy((*scratch)->numbers, view->numbers, (size_t) view->order * view->order * sizeof(double));
+    return *scratch;
+}
 
 void * compute_determinant_thread_worker(void * arg) {
     unsigned int threadId = *((int*) arg);
-    bool continue_working = true;
-    do {
-        // initializations
-        double determinant = 0;
-        MatrixHandler * matrixHandler;
+    MatrixHandler * batch[MAX_BATCH_SIZE];
+    // the elimination runs on a copy of the views of mapped files
+    Matrix * scratch = NULL;
+    unsigned int scratchCapacity = 0;
+    // the order of the next matrices is not known, the last one fetched is the best guess
+    unsigned int batchSize = 1;
+    unsigned int n;
+
+    // fetch matrices from the fifo
+    while((n = getMatrices(threadId, batch, batchSize)) > 0) {
+        // the matrices go back to their pools once registered
+        batchSize = matrix_batch_size(batch[n-1]->matrix->order);
 
-        // fetch matrix from the fifo
-        continue_working = getMatrix(threadId, &matrixHandler);
+        for(int i=0;i<n;i++) {
+            MatrixHandler * matrixHandler = batch[i];
+            Matrix * matrix = matrixHandler->matrix;
+            if(matrixHandler->pool == NULL) {
+                matrix = copy_to_scratch(&scratch, &scratchCapacity, matrix);
+            }
+
+            // large matrices of files with few of them are split among a team of threads
+            unsigned int teamSize = determinant_team_size(matrix->order, sm_getMatrixCount(matrixHandler->fileIdx),
+                                                         nDeterminantWorkers);
 
-        if(continue_working) {        
             // compute determinant
-            determinant = compute_determinant(*(matrixHandler->matrix));
+            double determinant;
+            if(teamSize > 1) {
+                determinant = compute_determinant_team(*matrix, determinantKernel, teamSize);
+            }
+            else if(determinantKernel == LU_KERNEL) {
+                determinant = compute_determinant_lu(*matrix);
+            }
+            else {
+                determinant = compute_determinant(*matrix);
+            }
 
             // register
             sm_registerResult(matrixHandler, determinant);
         }
-    } while(continue_working);
+    }
 
+    free_matrix(scratch);
     return EXIT_SUCCESS;
 }
 
-
@@ -16,6 +16,13 @@
  */
 
 
+/** \brief Determinant kernels */
+enum DeterminantKernel {
+    GAUSS_KERNEL,   /*!< Gaussian elimination, rows are switched only on zero pivots */
+    LU_KERNEL       /*!< Blocked LU factorization with partial pivoting */
+};
+
+
 /** \brief worker which computes matrices
  *  
  *  Operation carried out by worker thread.
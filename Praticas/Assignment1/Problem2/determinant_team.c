@@ -0,0 +1,186 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "determinant_team.h"
+#include "lu_determinant.h"
+#include "affinity.h"
+#include "constants.h"
+
+
+/** \brief State shared by the members of a team */
+typedef struct sTeam {
+    Matrix matrix;                  /*!< matrix being computed */
+    enum DeterminantKernel kernel;  /*!< elimination split among the members */
+    unsigned int size;              /*!< number of members */
+    pthread_barrier_t barrier;      /*!< members synchronization point between steps */
+    bool singular;                  /*!< a panel without pivot was found, LU only */
+} Team;
+
+/** \brief Member of a team */
+typedef struct sMember {
+    Team * team;
+    unsigned int id;                /*!< 0 for the leader */
+} Member;
+
+
+unsigned int determinant_team_size(unsigned int order, unsigned int nMatrices, unsigned int nWorkers) {
+    if(order < TEAM_MIN_ORDER || nMatrices == 0 || nMatrices >= nWorkers) {
+        return 1;
+    }
+
+    unsigned int size = nWorkers / nMatrices;
+    long nProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+    if(nProcessors > 0 && size > nProcessors) {
+        size = nProcessors;
+    }
+    return size;
+}
+
+/** \brief Gaussian elimination of a member
+ *
+ *  Same steps as compute_determinant. The pivot row is switched by the leader, the rows below it are
+ *  dealt cyclically so that every member keeps its share as the matrix shrinks.
+ *
+ *  \param member member of the team
+ *
+ *  \returns determinant of the matrix, meaningful for the leader only
+ */
+static double gauss_member(Member * member) {
+    Team * team = member->team;
+    double * a = team->matrix.numbers;
+    unsigned int order = team->matrix.order;
+    int sign = 1;
+    double determinant = 1;
+
+    for(unsigned int i=0;i<order;i++) {
+        double * pivotRow = a + (size_t) i * order;
+
+        // every member sees the same pivot, nobody writes until they all looked at it
+        if(pivotRow[i] == 0) {
+            pthread_barrier_wait(&team->barrier);
+            if(member->id == 0) {
+                for(unsigned int j=i+1;j<order;j++) {
+                    if(a[(size_t) j * order + i] != 0) {
+                        switch_row(team->matrix, i, j);
+                        sign = (sign == 1) ? -1: 1;
+                        break;
+                    }
+                }
+            }
+            pthread_barrier_wait(&team->barrier);
+        }
+
+        // first row below the pivot owned by the member
+        unsigned int j = i + 1 + (member->id + team->size - (i + 1) % team->size) % team->size;
+        for(;j<order;j+=team->size) {
+            double * row = a + (size_t) j * order;
+            double ratio = row[i]/pivotRow[i];
+            for(unsigned int k=i+1;k<order;k++) {
+                row[k] = row[k]-ratio*pivotRow[k];
+            }
+        }
+        determinant *= pivotRow[i];
+
+        pthread_barrier_wait(&team->barrier);
+    }
+
+    return determinant * sign;
+}
+
+/** \brief Blocked LU factorization of a member
+ *
+ *  Same steps as compute_determinant_lu. The leader factorizes the panel and solves U12, the trailing
+ *  update is split in blocks of rows, multiples of the 4 rows tiles of the kernel.
+ *
+ *  \param member member of the team
+ *
+ *  \returns determinant of the matrix, meaningful for the leader only
+ */
+static double lu_member(Member * member) {
+    Team * team = member->team;
+    double * a = team->matrix.numbers;
+    unsigned int order = team->matrix.order;
+    double determinant = 1;
+
+    for(unsigned int kb=0;kb<order;kb+=LU_BLOCK_SIZE) {
+        unsigned int nb = (order - kb < LU_BLOCK_SIZE) ? order - kb : LU_BLOCK_SIZE;
+        unsigned int panelEnd = kb + nb;
+
+        if(member->id == 0) {
+            if(!lu_factorize_panel(a, order, kb, nb, &determinant)) {
+                team->singular = true;
+            }
+            else if(panelEnd < order) {
+                lu_solve_panel_rows(a, order, kb, nb);
+            }
+        }
+        pthread_barrier_wait(&team->barrier);
+
+        if(team->singular || panelEnd == order) {
+            break;
+        }
+
+        // A22 -= L21 * U12, rows of the member
+        unsigned int blockSize = ((order - panelEnd + team->size - 1) / team->size + 3) / 4 * 4;
+        unsigned int rowBegin = panelEnd + member->id * blockSize;
+        unsigned int rowEnd = (rowBegin + blockSize < order) ? rowBegin + blockSize : order;
+        if(rowBegin < order) {
+            lu_trailing_update(a, order, kb, nb, rowBegin, rowEnd);
+        }
+        pthread_barrier_wait(&team->barrier);
+    }
+
+    return team->singular ? 0 : determinant;
+}
+
+/** \brief Routine of the members started for a matrix */
+static void * team_member(void * arg) {
+    Member * member = (Member*) arg;
+    if(member->team->kernel == LU_KERNEL) {
+        lu_member(member);
+    }
+    else {
+        gauss_member(member);
+    }
+    return NULL;
+}
+
+double compute_determinant_team(Matrix matrix, enum DeterminantKernel kernel, unsigned int teamSize) {
+    Team team = {matrix, kernel, teamSize};
+    team.singular = false;
+    pthread_barrier_init(&team.barrier, NULL, teamSize);
+
+    pthread_t threads[teamSize];
+    Member members[teamSize];
+    for(unsigned int i=0;i<teamSize;i++) {
+        members[i].team = &team;
+        members[i].id = i;
+    }
+    // members of a pinned leader take the processors after its own
+    int slot = affinity_slot();
+    for(unsigned int i=1;i<teamSize;i++) {
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        if(slot >= 0) {
+            affinity_set(&attr, slot + i);
+        }
+        if(pthread_create(&threads[i], &attr, team_member, &members[i]) != 0) {
+            perror("Error creating team member");
+            exit(EXIT_FAILURE);
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    // the calling thread leads the team
+    double determinant = (kernel == LU_KERNEL) ? lu_member(&members[0]) : gauss_member(&members[0]);
+
+    for(unsigned int i=1;i<teamSize;i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&team.barrier);
+
+    return determinant;
+}
@@ -0,0 +1,53 @@
+#ifndef DETERMINANT_TEAM_H
+#define DETERMINANT_TEAM_H
+
+#include "matrix.h"
+#include "determinant_calculation.h"
+
+/**
+ *  \file determinant_team.h
+ *
+ *  \brief Determinant of a single matrix computed by a team of threads
+ *
+ *  The computing worker that fetched the matrix leads the team and the other members are started for
+ *  that matrix only. Each elimination step is split by rows among the members, which meet at a
+ *  barrier before the next step:
+ *     \li gaussian elimination, the rows below the pivot are dealt cyclically, one barrier per pivot
+ *     \li blocked LU, the leader factorizes the panel and solves U12, the members split the trailing
+ *         update in blocks of rows, two barriers per panel.
+ *
+ *  Every coefficient goes through the same operations as with a single thread, so the determinant
+ *  is the same as the one of compute_determinant or compute_determinant_lu.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+
+/** \brief Number of threads to compute a matrix with
+ *
+ *  Matrices below TEAM_MIN_ORDER, and files with a matrix for every computing worker, are computed by
+ *  a single thread. Otherwise the computing workers are shared by the matrices of the file, never more
+ *  than the online processors.
+ *
+ *  \param order order of the matrix
+ *  \param nMatrices number of matrices of its file
+ *  \param nWorkers number of computing workers
+ *
+ *  \returns size of the team, 1 to compute the matrix alone
+*/
+unsigned int determinant_team_size(unsigned int order, unsigned int nMatrices, unsigned int nWorkers);
+
+
+/** \brief Computes the determinant of a matrix with a team of threads
+ *
+ *  The calling thread is a member of the team. The matrix is overwritten.
+ *
+ *  \param matrix Matrix to be used
+ *  \param kernel elimination to split among the team
+ *  \param teamSize number of threads, the calling one included
+ *
+ *  \returns double value of the determinant of the matrix given as input
+*/
+double compute_determinant_team(Matrix matrix, enum DeterminantKernel kernel, unsigned int teamSize);
+
+#endif /* DETERMINANT_TEAM_H */
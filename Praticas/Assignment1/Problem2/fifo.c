@@ -3,85 +3,263 @@
  *
  *  \brief Problem name: Producers / Consumers.
  *
- *  Synchronization based on monitors.
- *  Both threads and the monitor are implemented using the pthread library which enables the creation of a
- *  monitor of the Lampson / Redell type.
+ *  Lock-free bounded multi-producer / multi-consumer queue (D. Vyukov).
  *
- *  Data transfer region implemented as a monitor.
+ *  Every cell of the ring holds a sequence number. A producer may fill the cell at position pos when
+ *  its sequence is pos, a consumer may empty it when its sequence is pos + 1. Producers and consumers
+ *  claim positions with a compare-and-swap on their own counter and publish the cell by storing its
+ *  next sequence, so neither side takes a lock.
+ *
+ *  Threads that find the queue full (producers) or empty (consumers) spin for FIFO_SPIN_COUNT tries
+ *  and then park on a futex, woken only when the other side has registered sleepers. On a single
+ *  processor spinning only delays the thread that would make progress, so threads park at once.
  *
  *  Definition of the operations carried out by the producers / consumers:
- *     \li putVal
- *     \li getVal.
+ *     \li putMatrix / putMatrices
+ *     \li getMatrix / getMatrices
+ *     \li doneReading.
  *
- *  \author António Rui Borges - March 2019
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
  */
 
+#ifndef FIFO_MONITOR
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdbool.h>
-#include <unistd.h>
+#include <stdint.h>
+#include <stdatomic.h>
 #include <pthread.h>
-#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
 
 #include "fifo.h"
 #include "constants.h"
 
-/** \brief producer threads return status array */
-extern int statusProd[N_FILE_READER_WORKERS];
+/** \brief number of tries before parking on the futex */
+#define FIFO_SPIN_COUNT 128
+
+/** \brief size of a cache line, the counters of producers and consumers never share one */
+#define CACHE_LINE_SIZE 64
 
-/** \brief consumer threads return status array */
-extern int statusCons[N_DETERMINANT_WORKERS];
+/** \brief Cell of the ring */
+struct sCell {
+    atomic_size_t sequence;         /*!< position the cell is ready for, pos to be filled, pos + 1 to be emptied */
+    MatrixHandler * value;          /*!< stored value */
+};
 
-/** \brief storage region */
-static MatrixHandler * mem[FIFO_MAX_SIZE];
+/** \brief storage region, allocated on first use */
+static struct sCell * mem;
 
-/** \brief insertion pointer */
-static unsigned int ii;
+/** \brief number of cells of the storage region */
+static size_t fifoSize = FIFO_MAX_SIZE;
 
-/** \brief retrieval pointer */
-static unsigned int ri;
+/** \brief insertion position */
+static _Alignas(CACHE_LINE_SIZE) atomic_size_t ii;
 
-/** \brief flag signaling the data transfer region is full */
-static bool full;
+/** \brief retrieval position */
+static _Alignas(CACHE_LINE_SIZE) atomic_size_t ri;
 
-/** \brief locking flag which warrants mutual exclusion inside the monitor */
-static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
+/** \brief futex word of the consumers, incremented whenever a value is stored or reading is done */
+static _Alignas(CACHE_LINE_SIZE) atomic_uint valueStored;
 
-/** \brief flag which warrants that the data transfer region is initialized exactly once */
-static pthread_once_t init = PTHREAD_ONCE_INIT;;
+/** \brief number of consumers parked on valueStored */
+static atomic_uint sleepingConsumers;
 
-/** \brief producers synchronization point when the data transfer region is full */
-static pthread_cond_t fifoFull;
+/** \brief futex word of the producers, incremented whenever a value is retrieved */
+static _Alignas(CACHE_LINE_SIZE) atomic_uint valueRetrieved;
 
-/** \brief consumers synchronization point when the data transfer region is empty */
-static pthread_cond_t fifoEmpty;
+/** \brief number of producers parked on valueRetrieved */
+static atomic_uint sleepingProducers;
 
 /** \brief represents that there are not more matrices to be inserted */
-static bool blockPuts = false;
+static atomic_bool blockPuts = false;
+
+/** \brief number of tries before parking, 0 on a single processor */
+static int spinCount;
+
+/** \brief the sequence numbers are initialized exactly once */
+static pthread_once_t init = PTHREAD_ONCE_INIT;
 
 /**
  *  \brief Initialization of the data transfer region.
  *
- *  Internal monitor operation.
+ *  Internal operation.
  */
 
 static void initialization (void)
 {
-                                                                                   /* initialize FIFO in empty state */
-  ii = ri = 0;                                        /* FIFO insertion and retrieval pointers set to the same value */
-  full = false;                                                                                  /* FIFO is not full */
+  if ((mem = malloc (fifoSize * sizeof (struct sCell))) == NULL)
+  { perror ("error on allocating the fifo");
+    exit (EXIT_FAILURE);
+  }
+  for (size_t i = 0; i < fifoSize; i++)
+    atomic_store_explicit (&mem[i].sequence, i, memory_order_relaxed);
+  atomic_store (&ii, 0);
+  atomic_store (&ri, 0);
+  spinCount = (sysconf (_SC_NPROCESSORS_ONLN) > 1) ? FIFO_SPIN_COUNT : 0;
+}
 
-  pthread_cond_init (&fifoFull, NULL);                                 /* initialize producers synchronization point */
-  pthread_cond_init (&fifoEmpty, NULL);                                /* initialize consumers synchronization point */
+/** \brief Parks the calling thread while the futex word keeps the given value */
+static void futexWait (atomic_uint *word, unsigned int value)
+{
+  syscall (SYS_futex, (uint32_t *) word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
 }
 
+/** \brief Wakes up to n threads parked on the futex word */
+static void futexWake (atomic_uint *word, int n)
+{
+  syscall (SYS_futex, (uint32_t *) word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
 
+/** \brief Pause inside a spinning loop */
+static inline void cpuRelax (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause ();
+#endif
+}
+
+/**
+ *  \brief Tries to store a value.
+ *
+ *  \param val value to be stored
+ *
+ *  \return true if the value was stored, false if the fifo is full
+ */
+
+static bool tryPut (MatrixHandler * val)
+{
+  size_t pos = atomic_load_explicit (&ii, memory_order_relaxed);
+  while (true)
+  { struct sCell *cell = &mem[pos % fifoSize];
+    size_t sequence = atomic_load_explicit (&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+    if (diff == 0)                                                                       /* the cell is empty, claim it */
+    { if (atomic_compare_exchange_weak_explicit (&ii, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+      { cell->value = val;
+        atomic_store_explicit (&cell->sequence, pos + 1, memory_order_release);           /* publish it to consumers */
+        return true;
+      }
+    }
+    else if (diff < 0)                                                   /* the cell was not emptied yet, fifo is full */
+      return false;
+    else pos = atomic_load_explicit (&ii, memory_order_relaxed);                  /* another producer took the cell */
+  }
+}
+
+/**
+ *  \brief Tries to retrieve a value.
+ *
+ *  \param val retrieved value
+ *
+ *  \return true if a value was retrieved, false if the fifo is empty
+ */
+
+static bool tryGet (MatrixHandler ** val)
+{
+  size_t pos = atomic_load_explicit (&ri, memory_order_relaxed);
+  while (true)
+  { struct sCell *cell = &mem[pos % fifoSize];
+    size_t sequence = atomic_load_explicit (&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+    if (diff == 0)                                                                        /* the cell is full, claim it */
+    { if (atomic_compare_exchange_weak_explicit (&ri, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+      { *val = cell->value;
+        atomic_store_explicit (&cell->sequence, pos + fifoSize, memory_order_release);        /* ready for next lap */
+        return true;
+      }
+    }
+    else if (diff < 0)                                                  /* the cell was not filled yet, fifo is empty */
+      return false;
+    else pos = atomic_load_explicit (&ri, memory_order_relaxed);                  /* another consumer took the cell */
+  }
+}
+
+void setFifoSize(unsigned int size) {
+  /* with a single cell, full and empty would have the same sequence */
+  fifoSize = (size < 2) ? 2 : size;
+}
 
 void doneReading() {
-  pthread_mutex_lock (&accessCR);
-  blockPuts = true;
-  pthread_cond_broadcast (&fifoEmpty);
-  pthread_mutex_unlock (&accessCR);
+  pthread_once (&init, initialization);
+  atomic_store (&blockPuts, true);
+  atomic_fetch_add (&valueStored, 1);
+  futexWake (&valueStored, INT_MAX);
+}
+
+/**
+ *  \brief Lets parked consumers know that values have been stored.
+ *
+ *  \param n number of values stored since the last notification
+ */
+
+static void notifyConsumers (unsigned int n)
+{
+  atomic_fetch_add (&valueStored, 1);
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load (&sleepingConsumers) > 0)
+    futexWake (&valueStored, (n > INT_MAX) ? INT_MAX : (int) n);
+}
+
+/**
+ *  \brief Lets parked producers know that values have been retrieved.
+ *
+ *  \param n number of values retrieved
+ */
+
+static void notifyProducers (unsigned int n)
+{
+  atomic_fetch_add (&valueRetrieved, 1);
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load (&sleepingProducers) > 0)
+    futexWake (&valueRetrieved, (n > INT_MAX) ? INT_MAX : (int) n);
+}
+
+/**
+ *  \brief Store several values in the data transfer region.
+ *
+ *  Operation carried out by the producers. The consumers are only notified before parking for room
+ *  and once the batch is stored.
+ *
+ *  \param prodId producer identification
+ *  \param vals values to be stored
+ *  \param n number of values
+ */
+
+void putMatrices(unsigned int prodId, MatrixHandler ** vals, unsigned int n)
+{
+  pthread_once (&init, initialization);                                              /* internal data initialization */
+
+  unsigned int pending = 0;                                                 /* values stored but not notified yet */
+  for (unsigned int i = 0; i < n; i++)
+  { for (int spin = 0; !tryPut (vals[i]); spin++)                                   /* wait if the fifo is full */
+    { if (spin < spinCount)
+      { cpuRelax ();
+        continue;
+      }
+
+      if (pending > 0)                                     /* the values stored so far must be retrieved first */
+      { notifyConsumers (pending);
+        pending = 0;
+      }
+      unsigned int event = atomic_load (&valueRetrieved);
+      atomic_fetch_add (&sleepingProducers, 1);
+      atomic_thread_fence (memory_order_seq_cst);
+      if (tryPut (vals[i]))                                         /* a value was retrieved before parking */
+      { atomic_fetch_sub (&sleepingProducers, 1);
+        break;
+      }
+      futexWait (&valueRetrieved, event);
+      atomic_fetch_sub (&sleepingProducers, 1);
+    }
+    pending++;
+  }
+
+  if (pending > 0)                                   /* let the consumers know that values have been stored */
+    notifyConsumers (pending);
 }
 
 /**
@@ -95,99 +273,72 @@ void doneReading() {
 
 void putMatrix(unsigned int prodId, MatrixHandler * val)
 {
-
-  if ((statusProd[prodId] = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
-     { errno = statusProd[prodId];                                                            /* save error in errno */
-       perror ("error on entering monitor(CF)");
-       statusProd[prodId] = EXIT_FAILURE;
-       pthread_exit (&statusProd[prodId]);
-     }
-  pthread_once (&init, initialization);                                              /* internal data initialization */
-  
-
-  while (full)                                                           /* wait if the data transfer region is full */
-  { if ((statusProd[prodId] = pthread_cond_wait (&fifoFull, &accessCR)) != 0)
-       { errno = statusProd[prodId];                                                          /* save error in errno */
-         perror ("error on waiting in fifoFull");
-         statusProd[prodId] = EXIT_FAILURE;
-         pthread_exit (&statusProd[prodId]);
-       }
-  }
-
-  mem[ii] = val;
-  ii = (ii + 1) % FIFO_MAX_SIZE;
-  full = (ii == ri);
-
-  if ((statusProd[prodId] = pthread_cond_signal (&fifoEmpty)) != 0)      /* let a consumer know that a value has been
-                                                                                                               stored */
-     { errno = statusProd[prodId];                                                             /* save error in errno */
-       perror ("error on signaling in fifoEmpty");
-       statusProd[prodId] = EXIT_FAILURE;
-       pthread_exit (&statusProd[prodId]);
-     }
-
-  if ((statusProd[prodId] = pthread_mutex_unlock (&accessCR)) != 0)                                  /* exit monitor */
-     { errno = statusProd[prodId];                                                            /* save error in errno */
-       perror ("error on exiting monitor(CF)");
-       statusProd[prodId] = EXIT_FAILURE;
-       pthread_exit (&statusProd[prodId]);
-     }
-    
+  putMatrices (prodId, &val, 1);
 }
 
 /**
- *  \brief Get a value from the data transfer region.
+ *  \brief Get several values from the data transfer region.
  *
- *  Operation carried out by the consumers.
+ *  Operation carried out by the consumers. Waits for at least one value and retrieves the ones stored
+ *  at that moment, up to max.
  *
  *  \param consId consumer identification
+ *  \param vals retrieved values
+ *  \param max maximum number of values to retrieve
  *
- *  \return value
+ *  \return number of retrieved values, 0 if the fifo is empty and reading is done
  */
 
-bool getMatrix(unsigned int consId, MatrixHandler ** val)
+unsigned int getMatrices(unsigned int consId, MatrixHandler ** vals, unsigned int max)
 {
-
-  if ((statusCons[consId] = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
-     { errno = statusCons[consId];                                                            /* save error in errno */
-       perror ("error on entering monitor(CF)");
-       statusCons[consId] = EXIT_FAILURE;
-       pthread_exit (&statusCons[consId]);
-     }
   pthread_once (&init, initialization);                                              /* internal data initialization */
 
-  while ((ii == ri) && !full)                                           /* wait if the data transfer region is empty */
-  { 
-    if(blockPuts) {
-      pthread_mutex_unlock (&accessCR);
+  for (int spin = 0; !tryGet (&vals[0]); spin++)                                  /* wait if the fifo is empty */
+  { if (atomic_load (&blockPuts))                      /* every value was stored before reading was signaled done */
+    { if (tryGet (&vals[0]))
+        break;
       return 0;
     }
-    if ((statusCons[consId] = pthread_cond_wait (&fifoEmpty, &accessCR)) != 0)
-       {
-         errno = statusCons[consId];                                                          /* save error in errno */
-         perror ("error on waiting in fifoEmpty");
-         statusCons[consId] = EXIT_FAILURE;
-         pthread_exit (&statusCons[consId]);
-       }
+    if (spin < spinCount)
+    { cpuRelax ();
+      continue;
+    }
+
+    unsigned int event = atomic_load (&valueStored);
+    atomic_fetch_add (&sleepingConsumers, 1);
+    atomic_thread_fence (memory_order_seq_cst);
+    if (tryGet (&vals[0]))                                             /* a value was stored before parking */
+    { atomic_fetch_sub (&sleepingConsumers, 1);
+      break;
+    }
+    if (!atomic_load (&blockPuts))
+      futexWait (&valueStored, event);
+    atomic_fetch_sub (&sleepingConsumers, 1);
   }
 
-  *val = mem[ri];                                                                   /* retrieve a  value from the FIFO */
-  ri = (ri + 1) % FIFO_MAX_SIZE;
-  full = false;
+  unsigned int n = 1;
+  while ((n < max) && tryGet (&vals[n]))                          /* take the values already stored, up to max */
+    n++;
 
-  if ((statusCons[consId] = pthread_cond_signal (&fifoFull)) != 0)       /* let a producer know that a value has been
+  notifyProducers (n);                                          /* let the producers know that values have been
                                                                                                             retrieved */
-     { errno = statusCons[consId];                                                             /* save error in errno */
-       perror ("error on signaling in fifoFull");
-       statusCons[consId] = EXIT_FAILURE;
-       pthread_exit (&statusCons[consId]);
-     }
-
-  if ((statusCons[consId] = pthread_mutex_unlock (&accessCR)) != 0)                                   /* exit monitor */
-     { errno = statusCons[consId];                                                             /* save error in errno */
-       perror ("error on exiting monitor(CF)");
-       statusCons[consId] = EXIT_FAILURE;
-       pthread_exit (&statusCons[consId]);
-     }
-  return true;
+  return n;
+}
+
+/**
+ *  \brief Get a value from the data transfer region.
+ *
+ *  Operation carried out by the consumers.
+ *
+ *  \param consId consumer identification
+ *  \param val retrieved value
+ *
+ *  \return true if a value was retrieved, false if the fifo is empty and reading is done
+ */
+
+bool getMatrix(unsigned int consId, MatrixHandler ** val)
+{
+  return getMatrices (consId, val, 1) != 0;
 }
+
+#endif /* FIFO_MONITOR */
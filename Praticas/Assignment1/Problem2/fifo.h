@@ -11,9 +11,21 @@ typedef struct sMatrixHandler {
     Matrix * matrix;
     int fileIdx;
     int matrixIdx;
+    struct sMatrixPool * pool;
 } MatrixHandler;
 
 
+/** \brief Sets the number of matrices the fifo holds
+ *  
+ *  Must be called before any other operation on the fifo, FIFO_MAX_SIZE otherwise.
+ *
+ *  The lock-free fifo holds at least 2 matrices.
+ *
+ *  \param size Number of matrices, at least one.
+ */
+extern void setFifoSize(unsigned int size);
+
+
 /** \brief Inserts a matrix inside the fifo
  *  
  *  \param id Worker thread id.
@@ -22,6 +34,17 @@ typedef struct sMatrixHandler {
 extern void putMatrix(unsigned int producerId, MatrixHandler * matrix);
 
 
+/** \brief Inserts several matrices inside the fifo
+ *  
+ *  Consumers are woken once for the whole batch instead of once per matrix.
+ *
+ *  \param producerId Worker thread id.
+ *  \param[in] matrices Matrices to be inserted, in order.
+ *  \param n Number of matrices.
+ */
+extern void putMatrices(unsigned int producerId, MatrixHandler ** matrices, unsigned int n);
+
+
 /** \brief Fetches a matrix from the fifo
  *  
  *  \param bool boolean which if TRUE, represents that there is more work for the thread, if FALSE, means that the thread can exit.
@@ -30,6 +53,17 @@ extern void putMatrix(unsigned int producerId, MatrixHandler * matrix);
  */
 extern bool getMatrix(unsigned int receiverId, MatrixHandler ** matrix);
 
+/** \brief Fetches several matrices from the fifo
+ *  
+ *  Waits until there is at least one matrix and takes the ones available at that moment, up to max.
+ *
+ *  \param[in] receiverId Worker thread id.
+ *  \param[out] matrices Fetched matrices, room for max of them.
+ *  \param max Maximum number of matrices to fetch.
+ *  \return Number of fetched matrices, 0 means that the thread can exit.
+ */
+extern unsigned int getMatrices(unsigned int receiverId, MatrixHandler ** matrices, unsigned int max);
+
 /** \brief Signal for the Fifo
  *  
  *  This signal represents that there is no more matrices available to insert into the memory.
@@ -0,0 +1,256 @@
+/**
+ *  \file fifo.c (implementation file)
+ *
+ *  \brief Problem name: Producers / Consumers.
+ *
+ *  Synchronization based on monitors.
+ *  Both threads and the monitor are implemented using the pthread library which enables the creation of a
+ *  monitor of the Lampson / Redell type.
+ *
+ *  Data transfer region implemented as a monitor.
+ *
+ *  Former implementation of the fifo, only compiled when FIFO_MONITOR is defined, in which case it
+ *  replaces the lock-free fifo of fifo.c.
+ *
+ *  Definition of the operations carried out by the producers / consumers:
+ *     \li putVal
+ *     \li getVal.
+ *
+ *  \author António Rui Borges - March 2019
+ */
+
+#ifdef FIFO_MONITOR
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include "fifo.h"
+#include "constants.h"
+
+/** \brief producer threads return status array */
+extern int * statusProd;
+
+/** \brief consumer threads return status array */
+extern int * statusCons;
+
+/** \brief storage region, allocated on first use */
+static MatrixHandler ** mem;
+
+/** \brief number of values of the storage region */
+static unsigned int fifoSize = FIFO_MAX_SIZE;
+
+/** \brief insertion pointer */
+static unsigned int ii;
+
+/** \brief retrieval pointer */
+static unsigned int ri;
+
+/** \brief flag signaling the data transfer region is full */
+static bool full;
+
+/** \brief locking flag which warrants mutual exclusion inside the monitor */
+static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
+
+/** \brief flag which warrants that the data transfer region is initialized exactly once */
+static pthread_once_t init = PTHREAD_ONCE_INIT;;
+
+/** \brief producers synchronization point when the data transfer region is full */
+static pthread_cond_t fifoFull;
+
+/** \brief consumers synchronization point when the data transfer region is empty */
+static pthread_cond_t fifoEmpty;
+
+/** \brief represents that there are not more matrices to be inserted */
+static bool blockPuts = false;
+
+/**
+ *  \brief Initialization of the data transfer region.
+ *
+ *  Internal monitor operation.
+ */
+
+static void initialization (void)
+{
+  if ((mem = malloc (fifoSize * sizeof (MatrixHandler *))) == NULL)
+  { perror ("error on allocating the fifo");
+    exit (EXIT_FAILURE);
+  }
+                                                                                   /* initialize FIFO in empty state */
+  ii = ri = 0;                                        /* FIFO insertion and retrieval pointers set to the same value */
+  full = false;                                                                                  /* FIFO is not full */
+
+  pthread_cond_init (&fifoFull, NULL);                                 /* initialize producers synchronization point */
+  pthread_cond_init (&fifoEmpty, NULL);                                /* initialize consumers synchronization point */
+}
+
+
+
+void setFifoSize(unsigned int size) {
+  fifoSize = size;
+}
+
+void doneReading() {
+  pthread_mutex_lock (&accessCR);
+  blockPuts = true;
+  pthread_cond_broadcast (&fifoEmpty);
+  pthread_mutex_unlock (&accessCR);
+}
+
+/**
+ *  \brief Store several values in the data transfer region.
+ *
+ *  Operation carried out by the producers. The monitor is entered once for the whole batch, the
+ *  consumers are only signaled before waiting for room and once the batch is stored.
+ *
+ *  \param prodId producer identification
+ *  \param vals values to be stored
+ *  \param n number of values
+ */
+
+void putMatrices(unsigned int prodId, MatrixHandler ** vals, unsigned int n)
+{
+
+  if ((statusProd[prodId] = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
+     { errno = statusProd[prodId];                                                            /* save error in errno */
+       perror ("error on entering monitor(CF)");
+       statusProd[prodId] = EXIT_FAILURE;
+       pthread_exit (&statusProd[prodId]);
+     }
+  pthread_once (&init, initialization);                                              /* internal data initialization */
+
+  for (unsigned int i = 0; i < n; i++)
+  { while (full)                                                         /* wait if the data transfer region is full */
+    { if ((statusProd[prodId] = pthread_cond_broadcast (&fifoEmpty)) != 0)      /* the values stored so far must be
+                                                                                                       retrieved first */
+         { errno = statusProd[prodId];                                                        /* save error in errno */
+           perror ("error on signaling in fifoEmpty");
+           statusProd[prodId] = EXIT_FAILURE;
+           pthread_exit (&statusProd[prodId]);
+         }
+      if ((statusProd[prodId] = pthread_cond_wait (&fifoFull, &accessCR)) != 0)
+         { errno = statusProd[prodId];                                                        /* save error in errno */
+           perror ("error on waiting in fifoFull");
+           statusProd[prodId] = EXIT_FAILURE;
+           pthread_exit (&statusProd[prodId]);
+         }
+    }
+
+    mem[ii] = vals[i];
+    ii = (ii + 1) % fifoSize;
+    full = (ii == ri);
+  }
+
+                                                     /* let the consumers know that values have been stored */
+  if ((statusProd[prodId] = (n == 1) ? pthread_cond_signal (&fifoEmpty) : pthread_cond_broadcast (&fifoEmpty)) != 0)
+     { errno = statusProd[prodId];                                                             /* save error in errno */
+       perror ("error on signaling in fifoEmpty");
+       statusProd[prodId] = EXIT_FAILURE;
+       pthread_exit (&statusProd[prodId]);
+     }
+
+  if ((statusProd[prodId] = pthread_mutex_unlock (&accessCR)) != 0)                                  /* exit monitor */
+     { errno = statusProd[prodId];                                                            /* save error in errno */
+       perror ("error on exiting monitor(CF)");
+       statusProd[prodId] = EXIT_FAILURE;
+       pthread_exit (&statusProd[prodId]);
+     }
+    
+}
+
+/**
+ *  \brief Store a value in the data transfer region.
+ *
+ *  Operation carried out by the producers.
+ *
+ *  \param prodId producer identification
+ *  \param val value to be stored
+ */
+
+void putMatrix(unsigned int prodId, MatrixHandler * val)
+{
+  putMatrices (prodId, &val, 1);
+}
+
+/**
+ *  \brief Get several values from the data transfer region.
+ *
+ *  Operation carried out by the consumers. Waits for at least one value and retrieves the ones stored
+ *  at that moment, up to max.
+ *
+ *  \param consId consumer identification
+ *  \param vals retrieved values
+ *  \param max maximum number of values to retrieve
+ *
+ *  \return number of retrieved values, 0 if the fifo is empty and reading is done
+ */
+
+unsigned int getMatrices(unsigned int consId, MatrixHandler ** vals, unsigned int max)
+{
+
+  if ((statusCons[consId] = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
+     { errno = statusCons[consId];                                                            /* save error in errno */
+       perror ("error on entering monitor(CF)");
+       statusCons[consId] = EXIT_FAILURE;
+       pthread_exit (&statusCons[consId]);
+     }
+  pthread_once (&init, initialization);                                              /* internal data initialization */
+
+  while ((ii == ri) && !full)                                           /* wait if the data transfer region is empty */
+  { 
+    if(blockPuts) {
+      pthread_mutex_unlock (&accessCR);
+      return 0;
+    }
+    if ((statusCons[consId] = pthread_cond_wait (&fifoEmpty, &accessCR)) != 0)
+       {
+         errno = statusCons[consId];                                                          /* save error in errno */
+         perror ("error on waiting in fifoEmpty");
+         statusCons[consId] = EXIT_FAILURE;
+         pthread_exit (&statusCons[consId]);
+       }
+  }
+
+  unsigned int n = 0;
+  do
+  { vals[n++] = mem[ri];                                                            /* retrieve a value from the FIFO */
+    ri = (ri + 1) % fifoSize;
+    full = false;
+  } while ((n < max) && (ii != ri));
+
+                                                  /* let the producers know that values have been retrieved */
+  if ((statusCons[consId] = (n == 1) ? pthread_cond_signal (&fifoFull) : pthread_cond_broadcast (&fifoFull)) != 0)
+     { errno = statusCons[consId];                                                             /* save error in errno */
+       perror ("error on signaling in fifoFull");
+       statusCons[consId] = EXIT_FAILURE;
+       pthread_exit (&statusCons[consId]);
+     }
+
+  if ((statusCons[consId] = pthread_mutex_unlock (&accessCR)) != 0)                                   /* exit monitor */
+     { errno = statusCons[consId];                                                             /* save error in errno */
+       perror ("error on exiting monitor(CF)");
+       statusCons[consId] = EXIT_FAILURE;
+       pthread_exit (&statusCons[consId]);
+     }
+  return n;
+}
+
+/**
+ *  \brief Get a value from the data transfer region.
+ *
+ *  Operation carried out by the consumers.
+ *
+ *  \param consId consumer identification
+ *
+ *  \return value
+ */
+
+bool getMatrix(unsigned int consId, MatrixHandler ** val)
+{
+  return getMatrices (consId, val, 1) != 0;
+}
+
+#endif /* FIFO_MONITOR */
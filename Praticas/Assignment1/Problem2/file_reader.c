@@ -1,63 +1,73 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "shared_memory.h"
 #include "fifo.h"
+#include "matrix_pool.h"
+
+/** \brief Reads the coefficients of a matrix
+ *
+ *  Several reader threads read the same file at once, so the offset is given to pread instead of
+ *  moving the file position. A matrix that can not be read whole is completed with zeros.
+ *
+ *  \param fileHandler FileHandler of the file
+ *  \param matrixIdx index of the matrix in the file
+ *  \param numbers coefficients of the matrix
+ */
+static void read_matrix(FileHandler * fileHandler, unsigned int matrixIdx, double * numbers) {
+    size_t size = (size_t) fileHandler->order * fileHandler->order * sizeof(double);
+    off_t offset = MATRIX_OFFSET(fileHandler->order, matrixIdx);
+    size_t done = 0;
+
+    while(done < size) {
+        ssize_t n = pread(fileHandler->fd, (char*) numbers + done, size - done, offset + done);
+        if(n <= 0) {
+            fprintf(stderr, "Error reading matrix %u of %s\n", matrixIdx, fileHandler->fileName);
+            memset((char*) numbers + done, 0, size - done);
+            return;
+        }
+        done += n;
+    }
+}
 
 void * file_reader_thread_worker(void * arg) {
     unsigned int threadId = *((int*) arg);
-    bool hasMoreWork = true;
-    while(hasMoreWork) {
-        FileHandler * fileHandler;
-        unsigned int fileIdx;
-        hasMoreWork = sm_getFile(&fileHandler, &fileIdx);
-
-        if(hasMoreWork==true) {
-            // open file
-            FILE * ptrFile = fopen(fileHandler->fileName, "r");
-
-            // check if file exists
-            if(ptrFile == NULL) {
-                perror("Error opening file");
-                printf("%s\n", fileHandler->fileName);
-                return (void *) EXIT_FAILURE;
-            }
-
-            
-            unsigned int nMatrices;
-            unsigned int order;
-
-            // get number of matrices and the order of the matrices
-            fread(&nMatrices, sizeof(unsigned int), 1, ptrFile);
-            fread(&order, sizeof(unsigned int), 1, ptrFile);
-
-            fileHandler->nMatrices = nMatrices;
-            fileHandler->determinants = (double*) malloc(sizeof(double)*nMatrices);
-            fileHandler->order = order;
-
-            for(int i=0;i<nMatrices;i++) {
+    FileHandler * fileHandler;
+    unsigned int fileIdx, first, count;
+
+    while(sm_getMatrixRange(&fileHandler, &fileIdx, &first, &count)) {
+        // matrices are read and inserted in batches sized after their order
+        unsigned int batchSize = matrix_batch_size(fileHandler->order);
+        MatrixHandler * batch[batchSize];
+        for(unsigned int i=first;i<first+count;i+=batchSize) {
+            unsigned int n = (first + count - i < batchSize) ? first + count - i : batchSize;
+
+            for(int j=0;j<n;j++) {
+                // mapped files are not read, the workers get views of their matrices
+                if(fileHandler->mapping != NULL) {
+                    batch[j] = sm_getMatrixView(fileHandler, i + j);
+                    continue;
+                }
 
-                MatrixHandler * matrixHandler = (MatrixHandler*) malloc(sizeof(MatrixHandler));
+                MatrixHandler * matrixHandler = pool_acquire(fileHandler->pool);
                 matrixHandler->fileIdx = fileIdx;
-                matrixHandler->matrixIdx = i;
-
-                matrixHandler->matrix = (Matrix*) malloc(sizeof(Matrix));
-
-                matrixHandler->matrix->numbers = (double **) malloc(sizeof(double*)*order);
-                matrixHandler->matrix->order = order;
+                matrixHandler->matrixIdx = i + j;
 
-                for(int i=0;i<order;i++) {
-                    // read matrix from files
-                    matrixHandler->matrix->numbers[i] = (double*) malloc(sizeof(double)*order);
-                    fread(matrixHandler->matrix->numbers[i], sizeof(double), order, ptrFile);
-                }
+                // single contiguous block per matrix, read at once
+                read_matrix(fileHandler, i + j, matrixHandler->matrix->numbers);
 
-                putMatrix(threadId, matrixHandler);
+                batch[j] = matrixHandler;
             }
+
+            putMatrices(threadId, batch, n);
         }
+
+        sm_doneMatrixRange(fileIdx);
     }
 
     return EXIT_SUCCESS;
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,234 @@
+#include <math.h>
+#include <stdbool.h>
+
+#include "lu_determinant.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LU_X86
+#endif
+
+/**
+ *  \file lu_determinant.c
+ *
+ *  \brief Blocked LU determinant kernel implementation
+ *
+ *  For each panel of columns [kb, kb + nb[:
+ *     \li the panel is factorized column by column, swapping whole rows with the largest pivot
+ *     \li the rows of the panel right of it are solved with the unit lower triangle of the panel (U12)
+ *     \li the trailing matrix is updated, A22 -= L21 * U12.
+ *
+ *  The trailing update takes most of the flops. It is done in tiles of 4 rows by 8 columns, keeping
+ *  the tile in registers while summing over the nb columns of the panel.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Trailing update kernel, A22 -= L21 * U12 on the rows [rowBegin, rowEnd[ of A22
+ *
+ *  \param a coefficients of the matrix
+ *  \param order order of the matrix
+ *  \param kb first column of the panel
+ *  \param nb number of columns of the panel
+ *  \param rowBegin first row to update
+ *  \param rowEnd end of the rows to update
+ */
+typedef void (*TrailingUpdate)(double * a, unsigned int order, unsigned int kb, unsigned int nb,
+                               unsigned int rowBegin, unsigned int rowEnd);
+
+/** \brief Kernel selected for the running CPU */
+static TrailingUpdate trailing_update;
+
+/** \brief Name of the kernel selected for the running CPU */
+static const char * kernelName = "scalar";
+
+/** \brief Trailing update of rows [rowBegin, rowEnd[ and columns [colBegin, order[, one element at a time */
+static void trailing_update_range(double * a, unsigned int order, unsigned int kb, unsigned int nb,
+                                  unsigned int rowBegin, unsigned int rowEnd, unsigned int colBegin) {
+    for(unsigned int i=rowBegin;i<rowEnd;i++) {
+        double * row = a + (size_t) i * order;
+        for(unsigned int p=kb;p<kb+nb;p++) {
+            double l = row[p];
+            const double * pivotRow = a + (size_t) p * order;
+            for(unsigned int c=colBegin;c<order;c++) {
+                row[c] -= l * pivotRow[c];
+            }
+        }
+    }
+}
+
+/** \brief Portable trailing update */
+static void trailing_update_scalar(double * a, unsigned int order, unsigned int kb, unsigned int nb,
+                                   unsigned int rowBegin, unsigned int rowEnd) {
+    trailing_update_range(a, order, kb, nb, rowBegin, rowEnd, kb + nb);
+}
+
+#ifdef LU_X86
+/** \brief AVX2 and FMA trailing update, 4x8 tiles kept in registers */
+__attribute__((target("avx2,fma"))) static void trailing_update_avx2(double * a, unsigned int order, unsigned int kb, unsigned int nb,
+                                                                    unsigned int rowBegin, unsigned int rowEnd) {
+    unsigned int first = kb + nb;
+    unsigned int tileEnd = rowBegin + (rowEnd - rowBegin) / 4 * 4;
+    unsigned int colEnd = first + (order - first) / 8 * 8;
+
+    for(unsigned int i=rowBegin;i<tileEnd;i+=4) {
+        double * r0 = a + (size_t) i * order;
+        double * r1 = r0 + order;
+        double * r2 = r1 + order;
+        double * r3 = r2 + order;
+
+        for(unsigned int c=first;c<colEnd;c+=8) {
+            __m256d c00 = _mm256_loadu_pd(r0 + c), c01 = _mm256_loadu_pd(r0 + c + 4);
+            __m256d c10 = _mm256_loadu_pd(r1 + c), c11 = _mm256_loadu_pd(r1 + c + 4);
+            __m256d c20 = _mm256_loadu_pd(r2 + c), c21 = _mm256_loadu_pd(r2 + c + 4);
+            __m256d c30 = _mm256_loadu_pd(r3 + c), c31 = _mm256_loadu_pd(r3 + c + 4);
+
+            for(unsigned int p=kb;p<first;p++) {
+                const double * pivotRow = a + (size_t) p * order + c;
+                __m256d u0 = _mm256_loadu_pd(pivotRow), u1 = _mm256_loadu_pd(pivotRow + 4);
+                __m256d l;
+
+                l = _mm256_broadcast_sd(r0 + p);
+                c00 = _mm256_fnmadd_pd(l, u0, c00); c01 = _mm256_fnmadd_pd(l, u1, c01);
+                l = _mm256_broadcast_sd(r1 + p);
+                c10 = _mm256_fnmadd_pd(l, u0, c10); c11 = _mm256_fnmadd_pd(l, u1, c11);
+                l = _mm256_broadcast_sd(r2 + p);
+                c20 = _mm256_fnmadd_pd(l, u0, c20); c21 = _mm256_fnmadd_pd(l, u1, c21);
+                l = _mm256_broadcast_sd(r3 + p);
+                c30 = _mm256_fnmadd_pd(l, u0, c30); c31 = _mm256_fnmadd_pd(l, u1, c31);
+            }
+
+            _mm256_storeu_pd(r0 + c, c00); _mm256_storeu_pd(r0 + c + 4, c01);
+            _mm256_storeu_pd(r1 + c, c10); _mm256_storeu_pd(r1 + c + 4, c11);
+            _mm256_storeu_pd(r2 + c, c20); _mm256_storeu_pd(r2 + c + 4, c21);
+            _mm256_storeu_pd(r3 + c, c30); _mm256_storeu_pd(r3 + c + 4, c31);
+        }
+
+        // columns left over by the tiles
+        for(unsigned int r=i;r<i+4;r++) {
+            double * row = a + (size_t) r * order;
+            for(unsigned int p=kb;p<first;p++) {
+                double l = row[p];
+                const double * pivotRow = a + (size_t) p * order;
+                for(unsigned int c=colEnd;c<order;c++) {
+                    row[c] -= l * pivotRow[c];
+                }
+            }
+        }
+    }
+
+    // rows left over by the tiles
+    trailing_update_range(a, order, kb, nb, tileEnd, rowEnd, first);
+}
+#endif
+
+/** \brief Selects the trailing update kernel for the running CPU at program startup */
+__attribute__((constructor)) static void select_kernel(void) {
+    trailing_update = trailing_update_scalar;
+#ifdef LU_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        trailing_update = trailing_update_avx2;
+        kernelName = "avx2+fma";
+    }
+#endif
+}
+
+const char * lu_kernel_name() {
+    return kernelName;
+}
+
+/** \brief Swaps two rows of the matrix */
+static void swap_rows(double * a, unsigned int order, unsigned int row1, unsigned int row2) {
+    double * numbers1 = a + (size_t) row1 * order;
+    double * numbers2 = a + (size_t) row2 * order;
+    for(unsigned int i=0;i<order;i++) {
+        double aux = numbers1[i];
+        numbers1[i] = numbers2[i];
+        numbers2[i] = aux;
+    }
+}
+
+bool lu_factorize_panel(double * a, unsigned int order, unsigned int kb, unsigned int nb, double * determinant) {
+    unsigned int panelEnd = kb + nb;
+
+    // factorize the panel, columns [kb, panelEnd[ of rows [kb, order[
+    for(unsigned int j=kb;j<panelEnd;j++) {
+        // partial pivoting, the largest coefficient of the column becomes the pivot
+        unsigned int pivot = j;
+        double largest = fabs(a[(size_t) j * order + j]);
+        for(unsigned int i=j+1;i<order;i++) {
+            double value = fabs(a[(size_t) i * order + j]);
+            if(value > largest) {
+                largest = value;
+                pivot = i;
+            }
+        }
+        if(largest == 0) {
+            return false;
+        }
+        if(pivot != j) {
+            swap_rows(a, order, j, pivot);
+            *determinant = -*determinant;
+        }
+
+        const double * pivotRow = a + (size_t) j * order;
+        *determinant *= pivotRow[j];
+
+        double inverse = 1 / pivotRow[j];
+        for(unsigned int i=j+1;i<order;i++) {
+            double * row = a + (size_t) i * order;
+            row[j] *= inverse;
+            double l = row[j];
+            for(unsigned int c=j+1;c<panelEnd;c++) {
+                row[c] -= l * pivotRow[c];
+            }
+        }
+    }
+
+    return true;
+}
+
+void lu_solve_panel_rows(double * a, unsigned int order, unsigned int kb, unsigned int nb) {
+    unsigned int panelEnd = kb + nb;
+
+    // U12, solve the rows of the panel with the unit lower triangle L11
+    for(unsigned int j=kb;j<panelEnd;j++) {
+        const double * pivotRow = a + (size_t) j * order;
+        for(unsigned int r=j+1;r<panelEnd;r++) {
+            double * row = a + (size_t) r * order;
+            double l = row[j];
+            for(unsigned int c=panelEnd;c<order;c++) {
+                row[c] -= l * pivotRow[c];
+            }
+        }
+    }
+}
+
+void lu_trailing_update(double * a, unsigned int order, unsigned int kb, unsigned int nb, unsigned int rowBegin, unsigned int rowEnd) {
+    trailing_update(a, order, kb, nb, rowBegin, rowEnd);
+}
+
+double compute_determinant_lu(Matrix matrix) {
+    double * a = matrix.numbers;
+    unsigned int order = matrix.order;
+    double determinant = 1;
+
+    for(unsigned int kb=0;kb<order;kb+=LU_BLOCK_SIZE) {
+        unsigned int nb = (order - kb < LU_BLOCK_SIZE) ? order - kb : LU_BLOCK_SIZE;
+        unsigned int panelEnd = kb + nb;
+
+        if(!lu_factorize_panel(a, order, kb, nb, &determinant)) {
+            return 0;
+        }
+        if(panelEnd == order) {
+            break;
+        }
+        lu_solve_panel_rows(a, order, kb, nb);
+
+        // A22 -= L21 * U12
+        lu_trailing_update(a, order, kb, nb, panelEnd, order);
+    }
+
+    return determinant;
+}
@@ -0,0 +1,78 @@
+#ifndef LU_DETERMINANT_H
+#define LU_DETERMINANT_H
+
+#include <stdbool.h>
+
+#include "matrix.h"
+
+/**
+ *  \file lu_determinant.h
+ *
+ *  \brief Blocked LU determinant kernel
+ *
+ *  The determinant is the signed product of the diagonal of U in the LU factorization with partial
+ *  pivoting PA = LU. The factorization is right-looking and blocked: a panel of LU_BLOCK_SIZE columns
+ *  is factorized, the matching block row of U is solved and the trailing matrix gets a rank
+ *  LU_BLOCK_SIZE update, vectorized with AVX2 and FMA when the running CPU supports them.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief number of columns of each panel */
+#define LU_BLOCK_SIZE 32
+
+/** \brief Computes the determinant of a matrix through its LU factorization
+ *  
+ *  The matrix is overwritten by its factors.
+ * 
+ *  \param matrix Matrix to be used
+ * 
+ *  \returns double value of the determinant of the matrix given as input
+*/
+double compute_determinant_lu(Matrix matrix);
+
+/** \brief Factorizes a panel, the first step of each block of compute_determinant_lu
+ *
+ *  Columns [kb, kb + nb[ of rows [kb, order[ become L11 / L21 and the diagonal of U11, swapping whole
+ *  rows with the largest pivot of each column.
+ *
+ *  \param a coefficients of the matrix
+ *  \param order order of the matrix
+ *  \param kb first column of the panel
+ *  \param nb number of columns of the panel
+ *  \param[in,out] determinant determinant so far, multiplied by the pivots and the swaps of the panel
+ *
+ *  \returns false if a column of the panel has no pivot, the determinant is then 0
+ */
+bool lu_factorize_panel(double * a, unsigned int order, unsigned int kb, unsigned int nb, double * determinant);
+
+/** \brief Solves the rows of a factorized panel right of it (U12) with its unit lower triangle
+ *
+ *  \param a coefficients of the matrix
+ *  \param order order of the matrix
+ *  \param kb first column of the panel
+ *  \param nb number of columns of the panel
+ */
+void lu_solve_panel_rows(double * a, unsigned int order, unsigned int kb, unsigned int nb);
+
+/** \brief Trailing update A22 -= L21 * U12 of the rows [rowBegin, rowEnd[
+ *
+ *  Rows are updated in tiles of 4 from rowBegin, so splitting the rows of A22 at multiples of 4 from
+ *  kb + nb gives the same result as a single call.
+ *
+ *  \param a coefficients of the matrix
+ *  \param order order of the matrix
+ *  \param kb first column of the panel
+ *  \param nb number of columns of the panel
+ *  \param rowBegin first row to update, at least kb + nb
+ *  \param rowEnd end of the rows to update, at most order
+ */
+void lu_trailing_update(double * a, unsigned int order, unsigned int kb, unsigned int nb, unsigned int rowBegin, unsigned int rowEnd);
+
+/** \brief Name of the trailing update kernel selected for the running CPU
+ *
+ *  \returns "avx2+fma" or "scalar"
+ */
+const char * lu_kernel_name();
+
+#endif /* LU_DETERMINANT_H */
@@ -1,5 +1,7 @@
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <pthread.h>
 
@@ -7,6 +9,8 @@
 #include "matrix.h"
 #include "file_reader.h"
 #include "determinant_calculation.h"
+#include "lu_determinant.h"
+#include "affinity.h"
 #include "constants.h"
 
 /**
@@ -26,13 +30,50 @@
 #define NS_PER_SECOND 1000000000
 
 /** \brief producer threads return status array */
-int statusProd[N_FILE_READER_WORKERS];
+int * statusProd;
 
 /** \brief consumer threads return status array */
-int statusCons[N_DETERMINANT_WORKERS];
+int * statusCons;
+
+/** \brief number of determinant computing threads */
+unsigned int nDeterminantWorkers = N_DETERMINANT_WORKERS;
+
+/** \brief number of file reading threads */
+unsigned int nReadingWorkers = N_FILE_READER_WORKERS;
+
+/** \brief number of matrices the fifo holds */
+unsigned int fifoSize = FIFO_MAX_SIZE;
+
+/** \brief threads are pinned to processors */
+static bool pinThreads = false;
+
+/** \brief kernel used to compute the determinants */
+enum DeterminantKernel determinantKernel = GAUSS_KERNEL;
+
+/** \brief way the matrices are taken from the files */
+static enum MatrixSource matrixSource = READ_SOURCE;
 
 int startWorkers(int nDeterminantWorkers, int nReadingWorkers);
 
+/** \brief Parses a number of threads or matrices given in the command line
+ *
+ *  \param arg option argument
+ *  \param name what the number is, for the error message
+ *  \param[out] value parsed number, at least one
+ *
+ *  \returns true if the argument is a positive number, false otherwise
+ */
+static bool parse_count(const char * arg, const char * name, unsigned int * value) {
+    char * end;
+    long parsed = strtol(arg, &end, 10);
+    if(*arg == '\0' || *end != '\0' || parsed < 1 || parsed > 65536) {
+        fprintf(stderr, "Invalid %s: %s\n", name, arg);
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
 /** \brief Main thread.
  *  
  *  The role of main thread is to get file names by processing the command line and storing them.
@@ -45,26 +86,78 @@ int main(int argc, char *argv[]) {
     unsigned int nFiles = 0;
 
     do {
-        switch((opt = getopt(argc, argv, "f:h"))) {
+        switch((opt = getopt(argc, argv, "f:k:mw:r:q:ah"))) {
             case 'f':
                 fileNames[nFiles] = optarg;
                 nFiles++;
                 break;
+
+            case 'k':
+                if(strcmp(optarg, "lu") == 0) {
+                    determinantKernel = LU_KERNEL;
+                }
+                else if(strcmp(optarg, "gauss") == 0) {
+                    determinantKernel = GAUSS_KERNEL;
+                }
+                else {
+                    fprintf(stderr, "Invalid kernel: %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
                 
+            case 'm':
+                matrixSource = MMAP_SOURCE;
+                break;
+
+            case 'w':
+                if(!parse_count(optarg, "number of computing workers", &nDeterminantWorkers)) {
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'r':
+                if(!parse_count(optarg, "number of reading workers", &nReadingWorkers)) {
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'q':
+                if(!parse_count(optarg, "fifo size", &fifoSize)) {
+                    return EXIT_FAILURE;
+                }
+                break;
+
+            case 'a':
+                pinThreads = true;
+                break;
+
             case 'h':
                 printf("-f      --- filename\n");
+                printf("-k      --- determinant kernel, gauss (default) or lu\n");
+                printf("-m      --- map the files instead of reading them\n");
+                printf("-w      --- number of computing workers (default %d)\n", N_DETERMINANT_WORKERS);
+                printf("-r      --- number of reading workers (default %d)\n", N_FILE_READER_WORKERS);
+                printf("-q      --- number of matrices the fifo holds (default %d)\n", FIFO_MAX_SIZE);
+                printf("-a      --- pin the threads to the processors\n");
                 break;
         }
     }
     while(opt != -1);
 
-    sm_init(fileNames, nFiles);
+    sm_init(fileNames, nFiles, matrixSource);
+    setFifoSize(fifoSize);
+    if(pinThreads && !affinity_init()) {
+        perror("Error getting the processors");
+    }
+
+    statusProd = (int*) malloc(nReadingWorkers * sizeof(int));
+    statusCons = (int*) malloc(nDeterminantWorkers * sizeof(int));
 
     // initialize time variables and start clock
     struct timespec startTime, stopTime;
     clock_gettime(CLOCK_MONOTONIC, &startTime);
 
-    startWorkers(N_DETERMINANT_WORKERS, N_FILE_READER_WORKERS);
+    startWorkers(nDeterminantWorkers, nReadingWorkers);
 
     // stop clock and compute elapsed time
     clock_gettime(CLOCK_MONOTONIC, &stopTime);
@@ -85,6 +178,8 @@ int main(int argc, char *argv[]) {
     
     // free memory
     sm_close();
+    free(statusProd);
+    free(statusCons);
 
     return EXIT_SUCCESS;
 }
@@ -102,16 +197,27 @@ int startWorkers(int nDeterminantWorkers, int nReadingWorkers) {
 
     // thread Ids
     int computingThreadIds[nDeterminantWorkers];
-    int readingThreadIds[nDeterminantWorkers];
+    int readingThreadIds[nReadingWorkers];
 
-    // create concurrent threads
+    // create concurrent threads, pinned by slot when asked: computing workers first, then readers
+    pthread_attr_t attr;
     for(int i=0;i<nDeterminantWorkers;i++) {
         computingThreadIds[i] = i;
-        pthread_create(&computingThreadWorkers[i], NULL, compute_determinant_thread_worker, (void*) &computingThreadIds[i]);
+        pthread_attr_init(&attr);
+        if(pinThreads) {
+            affinity_set(&attr, i);
+        }
+        pthread_create(&computingThreadWorkers[i], &attr, compute_determinant_thread_worker, (void*) &computingThreadIds[i]);
+        pthread_attr_destroy(&attr);
     }
     for(int i=0;i<nReadingWorkers;i++) {
         readingThreadIds[i] = i;
-        pthread_create(&readingThreadWorkers[i], NULL, file_reader_thread_worker, (void*) &readingThreadIds[i]);
+        pthread_attr_init(&attr);
+        if(pinThreads) {
+            affinity_set(&attr, nDeterminantWorkers + i);
+        }
+        pthread_create(&readingThreadWorkers[i], &attr, file_reader_thread_worker, (void*) &readingThreadIds[i]);
+        pthread_attr_destroy(&attr);
     }
 
     // end reading threads
@@ -1,14 +1,47 @@
-
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "matrix.h"
+#include "constants.h"
+
+
+/** \brief space taken by the Matrix in front of its coefficients, keeps them aligned */
+#define MATRIX_HEADER_SIZE ((sizeof(Matrix) + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT)
+
+
+Matrix * alloc_matrix(unsigned int order) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t size = MATRIX_HEADER_SIZE + (size_t) order * order * sizeof(double);
+    size = (size + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
+
+    Matrix * matrix = (Matrix*) aligned_alloc(MATRIX_ALIGNMENT, size);
+    if(matrix == NULL) {
+        return NULL;
+    }
+
+    matrix->order = order;
+    matrix->numbers = (double*) ((char*) matrix + MATRIX_HEADER_SIZE);
+    return matrix;
+}
+
+void free_matrix(Matrix * matrix) {
+    free(matrix);
+}
 
+unsigned int matrix_batch_size(unsigned int order) {
+    unsigned long work = (unsigned long) order * order * order;
+    if(work == 0 || work >= BATCH_WORK) {
+        return 1;
+    }
+    unsigned long batchSize = BATCH_WORK / work;
+    return (batchSize > MAX_BATCH_SIZE) ? MAX_BATCH_SIZE : (unsigned int) batchSize;
+}
 
 void print_matrix(Matrix * matrix) {
     for(int i=0; i<matrix->order; i++) {
         printf("%d\n", i);
         for(int j=0; j<matrix->order; j++) {
-            printf("%f  ", matrix->numbers[i][j]);
+            printf("%f  ", matrix->numbers[i * matrix->order + j]);
         }
         printf("\n");
     }
@@ -16,22 +49,27 @@ void print_matrix(Matrix * matrix) {
 
 void switch_row(Matrix matrix, int row1, int row2) {
     double aux;
+    double * numbers1 = matrix.numbers + row1 * matrix.order;
+    double * numbers2 = matrix.numbers + row2 * matrix.order;
     for(int i=0;i<matrix.order;i++) {
-        aux = matrix.numbers[row1][i];
-        matrix.numbers[row1][i] = matrix.numbers[row2][i];
-        matrix.numbers[row2][i] = aux;
+        aux = numbers1[i];
+        numbers1[i] = numbers2[i];
+        numbers2[i] = aux;
     }
 }
 
 double compute_determinant(Matrix matrix) {
     int sign = 1;
     double ratio, determinant = 1;
+    unsigned int order = matrix.order;
     
-    for(int i=0;i<matrix.order;i++) {
+    for(int i=0;i<order;i++) {
+        double * pivotRow = matrix.numbers + i * order;
+
         // check if the row can be used, otherwise, switch that row
-        if(matrix.numbers[i][i] == 0) {
-            for(int j=i+1;j<matrix.order;j++) {
-                if(matrix.numbers[j][i] != 0) {
+        if(pivotRow[i] == 0) {
+            for(int j=i+1;j<order;j++) {
+                if(matrix.numbers[j * order + i] != 0) {
                     switch_row(matrix, i, j);
                     sign = (sign == 1) ? -1: 1;
                     break;
@@ -39,14 +77,16 @@ double compute_determinant(Matrix matrix) {
             }                
         }
 
-        for(int j=i+1;j<matrix.order;j++) {
-            ratio = matrix.numbers[j][i]/matrix.numbers[i][i];
-            for(int k=0;k<matrix.order;k++) {
-                matrix.numbers[j][k] = matrix.numbers[j][k]-ratio*matrix.numbers[i][k];
+        // columns before i are never read again, only the trailing part of the rows is updated
+        for(int j=i+1;j<order;j++) {
+            double * row = matrix.numbers + j * order;
+            ratio = row[i]/pivotRow[i];
+            for(int k=i+1;k<order;k++) {
+                row[k] = row[k]-ratio*pivotRow[k];
             }
         }
-        determinant *= matrix.numbers[i][i];
+        determinant *= pivotRow[i];
     }
 
     return determinant * sign;
-}
\ No newline at end of file
+}
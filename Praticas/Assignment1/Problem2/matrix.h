@@ -1,4 +1,3 @@
-
 #ifndef MATRIX_H
 #define MATRIX_H
 
@@ -7,13 +6,52 @@
  * 
  */
 
-/** \brief Represents the Matrix */
+/** \brief alignment of the matrix coefficients, a cache line */
+#define MATRIX_ALIGNMENT 64
+
+/** \brief Represents the Matrix
+ *
+ *  The coefficients are stored row after row in a single block aligned to MATRIX_ALIGNMENT,
+ *  the coefficient of row i and column j is numbers[i * order + j].
+ */
 typedef struct sMatrix {
     unsigned int order;
-    double ** numbers;
+    double * numbers;
 } Matrix;
 
 
+/** \brief Allocates a matrix
+ *  
+ *  The Matrix and its coefficients are allocated in a single aligned block.
+ * 
+ *  \param order order of the matrix
+ * 
+ *  \returns pointer to the matrix, NULL if there is not enough memory
+*/
+Matrix * alloc_matrix(unsigned int order);
+
+
+/** \brief Frees a matrix allocated by alloc_matrix
+ *  
+ *  \param matrix pointer of the matrix to be freed
+ * 
+*/
+void free_matrix(Matrix * matrix);
+
+
+/** \brief Number of matrices of the given order moved through the fifo at once
+ *  
+ *  Batches hold about BATCH_WORK coefficient updates (order^3 per matrix) so that the synchronization
+ *  cost of small matrices is shared by the whole batch, up to MAX_BATCH_SIZE matrices. Large
+ *  matrices go one by one.
+ * 
+ *  \param order order of the matrices
+ * 
+ *  \returns batch size, between 1 and MAX_BATCH_SIZE
+*/
+unsigned int matrix_batch_size(unsigned int order);
+
+
 /** \brief Prints the matrix
  *  
  *  \param matrix pointer of the matrix to be printed
@@ -22,6 +60,16 @@ typedef struct sMatrix {
 void print_matrix(Matrix * matrix);
 
 
+/** \brief Switches two rows of a matrix
+ *  
+ *  \param matrix Matrix to be used
+ *  \param row1 first row
+ *  \param row2 second row
+ * 
+*/
+void switch_row(Matrix matrix, int row1, int row2);
+
+
 /** \brief Computes the determinant of a matrix
  *  
  *  \param matrix Matrix to be used
@@ -32,4 +80,4 @@ double compute_determinant(Matrix matrix);
 
 
 
-#endif /* MATRIX_H */
\ No newline at end of file
+#endif /* MATRIX_H */
@@ -0,0 +1,119 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "matrix_pool.h"
+#include "constants.h"
+
+
+/** \brief Round up to a multiple of MATRIX_ALIGNMENT */
+#define ALIGN_UP(size) (((size) + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT)
+
+/** \brief number of determinant computing threads */
+extern unsigned int nDeterminantWorkers;
+
+/** \brief number of file reading threads */
+extern unsigned int nReadingWorkers;
+
+/** \brief number of matrices the fifo holds */
+extern unsigned int fifoSize;
+
+/** \brief Represents the pool of matrices of a file */
+struct sMatrixPool {
+    pthread_mutex_t mutex;          /*!< mutex used for the threads syncronization */
+    pthread_cond_t slotFree;        /*!< readers synchronization point when every slot is in use */
+    unsigned char * slots;          /*!< storage of every slot */
+    size_t slotSize;                /*!< size of a slot */
+    MatrixHandler ** freeSlots;     /*!< stack of free slots */
+    unsigned int nFree;             /*!< number of free slots */
+    unsigned int remaining;         /*!< matrices of the file not given back yet */
+};
+
+/** \brief Slot layout: MatrixHandler, Matrix and the coefficients, each aligned to MATRIX_ALIGNMENT */
+struct sSlot {
+    MatrixHandler handler;
+    Matrix matrix;
+};
+
+
+MatrixPool * pool_create(unsigned int order, unsigned int nMatrices) {
+    MatrixPool * pool = (MatrixPool*) malloc(sizeof(MatrixPool));
+    if(pool == NULL) {
+        return NULL;
+    }
+
+    // the fifo, a batch per computing worker and the batch being read by each reader
+    unsigned int batchSize = matrix_batch_size(order);
+    unsigned int nQueued = nDeterminantWorkers * batchSize;
+    if(nQueued > fifoSize) {
+        nQueued = fifoSize;
+    }
+    unsigned int nSlots = nQueued + (nDeterminantWorkers + nReadingWorkers) * batchSize;
+    if(nSlots > nMatrices) {
+        nSlots = nMatrices;
+    }
+
+    size_t headerSize = ALIGN_UP(sizeof(struct sSlot));
+    pool->slotSize = headerSize + ALIGN_UP((size_t) order * order * sizeof(double));
+    pool->slots = (unsigned char*) aligned_alloc(MATRIX_ALIGNMENT, nSlots * pool->slotSize);
+    pool->freeSlots = (MatrixHandler**) malloc(nSlots * sizeof(MatrixHandler*));
+    if(pool->slots == NULL || pool->freeSlots == NULL) {
+        free(pool->slots);
+        free(pool->freeSlots);
+        free(pool);
+        return NULL;
+    }
+
+    for(int i=0;i<nSlots;i++) {
+        struct sSlot * slot = (struct sSlot*) (pool->slots + (size_t) i * pool->slotSize);
+        slot->matrix.order = order;
+        slot->matrix.numbers = (double*) ((unsigned char*) slot + headerSize);
+        slot->handler.matrix = &slot->matrix;
+        slot->handler.pool = pool;
+        pool->freeSlots[i] = &slot->handler;
+    }
+    pool->nFree = nSlots;
+    pool->remaining = nMatrices;
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pthread_cond_init(&pool->slotFree, NULL);
+
+    return pool;
+}
+
+/** \brief Frees the pool */
+static void pool_destroy(MatrixPool * pool) {
+    pthread_mutex_destroy(&pool->mutex);
+    pthread_cond_destroy(&pool->slotFree);
+    free(pool->slots);
+    free(pool->freeSlots);
+    free(pool);
+}
+
+MatrixHandler * pool_acquire(MatrixPool * pool) {
+    pthread_mutex_lock(&pool->mutex);
+
+    while(pool->nFree == 0) {
+        pthread_cond_wait(&pool->slotFree, &pool->mutex);
+    }
+    MatrixHandler * matrixHandler = pool->freeSlots[--pool->nFree];
+
+    pthread_mutex_unlock(&pool->mutex);
+    return matrixHandler;
+}
+
+void pool_release(MatrixHandler * matrixHandler) {
+    MatrixPool * pool = matrixHandler->pool;
+    pthread_mutex_lock(&pool->mutex);
+
+    pool->freeSlots[pool->nFree++] = matrixHandler;
+    bool lastMatrix = --pool->remaining == 0;
+    pthread_cond_signal(&pool->slotFree);
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    // the readers took every matrix of the file, nobody else uses the pool
+    if(lastMatrix) {
+        pool_destroy(pool);
+    }
+}
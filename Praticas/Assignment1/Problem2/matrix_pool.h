@@ -0,0 +1,57 @@
+#ifndef MATRIX_POOL_H
+#define MATRIX_POOL_H
+
+#include "fifo.h"
+
+/**
+ *  \file matrix_pool.h
+ *
+ *  \brief Pool of matrices of a file
+ *
+ *  Each file being read gets a pool of slots, allocated at once, holding a MatrixHandler, its Matrix
+ *  and the coefficients. The readers take a slot for each matrix of the file and the computing workers
+ *  give it back once the determinant is registered, so matrices never go through the general allocator.
+ *  The pool frees itself when the last matrix of the file is given back.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - April 2022
+ */
+
+/** \brief Opaque pool of matrices */
+typedef struct sMatrixPool MatrixPool;
+
+
+/** \brief Creates the pool of matrices of a file
+ *  
+ *  The pool has enough slots for the matrices in the fifo, a batch per computing worker and the batch
+ *  being read by each reader, but never more than the matrices of the file. At most a batch per
+ *  computing worker is kept in the fifo, so large matrices do not hold a slot for each place of the fifo.
+ * 
+ *  \param order order of the matrices
+ *  \param nMatrices number of matrices of the file, at least one
+ * 
+ *  \returns pointer to the pool, NULL if there is not enough memory
+*/
+MatrixPool * pool_create(unsigned int order, unsigned int nMatrices);
+
+
+/** \brief Takes a free slot of the pool
+ *  
+ *  Used by the file reader threads, blocks until a slot is given back if all are in use.
+ * 
+ *  \param pool pool of matrices
+ * 
+ *  \returns matrix handler with its matrix, of the order of the pool
+*/
+MatrixHandler * pool_acquire(MatrixPool * pool);
+
+
+/** \brief Gives a slot back to its pool
+ *  
+ *  Used by the determinant computing thread. Once the last matrix of the file is given back the
+ *  pool is freed.
+ * 
+ *  \param matrixHandler matrix handler taken from a pool
+*/
+void pool_release(MatrixHandler * matrixHandler);
+
+#endif /* MATRIX_POOL_H */
@@ -4,8 +4,14 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "shared_memory.h"
+#include "matrix_pool.h"
+#include "constants.h"
 
 
 /** \brief mutex used for the threads syncronization */
@@ -20,21 +26,42 @@ static FileHandler* files;
 /** \brief integer used to represent in which file the processing was the last that took place */
 static unsigned int currentFileIdx;
 
+/** \brief way the matrices are taken from the files */
+static enum MatrixSource matrixSource;
+
+/** \brief View of a matrix of a mapped file, its coefficients are those of the mapping */
+struct sMatrixView {
+    MatrixHandler handler;
+    Matrix matrix;
+};
+
 
 void sm_getResults(FileHandler ** results) {
     *results = files;
 }
 
 
-void sm_init(char ** fileNames, unsigned int numberFiles) {
+void sm_init(char ** fileNames, unsigned int numberFiles, enum MatrixSource source) {
     // variable initialization
     nFiles = numberFiles;
+    matrixSource = source;
     currentFileIdx = 0;
     files = (FileHandler*) malloc(nFiles * sizeof(FileHandler));
     
     for(int i=0;i<nFiles;i++) {
-        files[i].fileName = (char*) malloc(strlen(fileNames[i])*sizeof(char));
+        files[i].fileName = (char*) malloc((strlen(fileNames[i])+1)*sizeof(char));
         strcpy(files[i].fileName, fileNames[i]);
+        files[i].determinants = NULL;
+        files[i].nMatrices = 0;
+        files[i].order = 0;
+        files[i].opened = false;
+        files[i].fd = -1;
+        files[i].pool = NULL;
+        files[i].nextMatrix = 0;
+        files[i].nReading = 0;
+        files[i].mapping = NULL;
+        files[i].mappingSize = 0;
+        files[i].views = NULL;
     }
 }
 
@@ -43,6 +70,10 @@ void sm_close() {
     for(int i=0;i<nFiles;i++) {
         free(files[i].fileName);
         free(files[i].determinants);
+        if(files[i].mapping != NULL) {
+            munmap(files[i].mapping, files[i].mappingSize);
+        }
+        free(files[i].views);
     }
     free(files);
 }
@@ -52,13 +83,10 @@ void sm_registerResult(MatrixHandler * matrixHandler, double result) {
     FileHandler fh = files[matrixHandler->fileIdx];
     fh.determinants[matrixHandler->matrixIdx] = result;
 
-    // free matrix handler
-    for(int i=0;i<matrixHandler->matrix->order;i++) {
-        free(matrixHandler->matrix->numbers[i]);
+    // give the matrix back to the pool of its file, views have none
+    if(matrixHandler->pool != NULL) {
+        pool_release(matrixHandler);
     }
-    free(matrixHandler->matrix->numbers);
-    free(matrixHandler->matrix);
-    free(matrixHandler);
 }
 
 bool sm_getMatrix(MatrixHandler * matrixHandler) {
@@ -71,17 +99,171 @@ void sm_addMatrix(MatrixHandler matrixHandler) {
     putMatrix(threadId, &matrixHandler);
 }
 
-bool sm_getFile(FileHandler ** fileHandler, unsigned int * fileIdx) {
+/** \brief Maps a file and creates the views of its matrices
+ *
+ *  Called with the mutex locked. A file shorter than its header claims only keeps the matrices it
+ *  holds whole, the coefficients past its end can not be mapped.
+ *
+ *  \param fileHandler FileHandler of the file, opened
+ *  \param nMatrices number of matrices given by the header
+ *  \param order order of the matrices
+ *
+ *  \return true if the file was mapped, false otherwise
+ */
+static bool map_file(FileHandler * fileHandler, unsigned int nMatrices, unsigned int order) {
+    struct stat st;
+    if(fstat(fileHandler->fd, &st) == -1) {
+        perror("Error getting file size");
+        return false;
+    }
+
+    size_t matrixSize = (size_t) order * order * sizeof(double);
+    if(st.st_size < MATRIX_OFFSET(order, nMatrices)) {
+        unsigned int nWhole = (matrixSize == 0) ? 0 : (st.st_size - MATRIX_OFFSET(order, 0)) / matrixSize;
+        fprintf(stderr, "Error: %s holds %u of its %u matrices\n", fileHandler->fileName, nWhole, nMatrices);
+        nMatrices = nWhole;
+    }
+    fileHandler->nMatrices = nMatrices;
+    if(nMatrices == 0) {
+        return true;
+    }
+
+    fileHandler->mappingSize = MATRIX_OFFSET(order, nMatrices);
+    fileHandler->mapping = mmap(NULL, fileHandler->mappingSize, PROT_READ, MAP_PRIVATE, fileHandler->fd, 0);
+    if(fileHandler->mapping == MAP_FAILED) {
+        perror("Error mapping file");
+        fileHandler->mapping = NULL;
+        fileHandler->nMatrices = 0;
+        return false;
+    }
+    madvise(fileHandler->mapping, fileHandler->mappingSize, MADV_SEQUENTIAL);
+
+    fileHandler->views = (struct sMatrixView*) malloc(nMatrices * sizeof(struct sMatrixView));
+    if(fileHandler->views == NULL) {
+        perror("Error allocating the matrix views");
+        munmap(fileHandler->mapping, fileHandler->mappingSize);
+        fileHandler->mapping = NULL;
+        fileHandler->nMatrices = 0;
+        return false;
+    }
+    for(int i=0;i<nMatrices;i++) {
+        struct sMatrixView * view = &fileHandler->views[i];
+        view->matrix.order = order;
+        view->matrix.numbers = (double*) ((char*) fileHandler->mapping + MATRIX_OFFSET(order, i));
+        view->handler.matrix = &view->matrix;
+        view->handler.fileIdx = fileHandler - files;
+        view->handler.matrixIdx = i;
+        view->handler.pool = NULL;
+    }
+
+    return true;
+}
+
+/** \brief Opens a file, reads its header and creates its pool
+ *
+ *  Called with the mutex locked. The file is skipped, without matrices, if it can not be read.
+ *
+ *  \param fileHandler FileHandler of the file
+ */
+static void open_file(FileHandler * fileHandler) {
+    fileHandler->opened = true;
+
+    fileHandler->fd = open(fileHandler->fileName, O_RDONLY);
+    if(fileHandler->fd == -1) {
+        perror("Error opening file");
+        printf("%s\n", fileHandler->fileName);
+        return;
+    }
+
+    // get number of matrices and the order of the matrices
+    unsigned int header[2];
+    if(pread(fileHandler->fd, header, sizeof(header), 0) != sizeof(header)) {
+        fprintf(stderr, "Error reading header of %s\n", fileHandler->fileName);
+        close(fileHandler->fd);
+        fileHandler->fd = -1;
+        return;
+    }
+
+    if(header[0] > 0 && matrixSource == MMAP_SOURCE) {
+        if(!map_file(fileHandler, header[0], header[1])) {
+            close(fileHandler->fd);
+            fileHandler->fd = -1;
+            return;
+        }
+        header[0] = fileHandler->nMatrices;
+    }
+    else if(header[0] > 0) {
+        // the matrices of the file live in its pool, given back by the computing workers
+        fileHandler->pool = pool_create(header[1], header[0]);
+        if(fileHandler->pool == NULL) {
+            perror("Error allocating matrix pool");
+            close(fileHandler->fd);
+            fileHandler->fd = -1;
+            return;
+        }
+        posix_fadvise(fileHandler->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    }
+
+    fileHandler->nMatrices = header[0];
+    fileHandler->order = header[1];
+    fileHandler->determinants = (double*) malloc(sizeof(double)*header[0]);
+
+    // a mapping stays valid once its descriptor is closed
+    if(fileHandler->nMatrices == 0 || fileHandler->mapping != NULL) {
+        close(fileHandler->fd);
+        fileHandler->fd = -1;
+    }
+}
+
+bool sm_getMatrixRange(FileHandler ** fileHandler, unsigned int * fileIdx, unsigned int * first, unsigned int * count) {
     pthread_mutex_lock(&mutex);
     bool hasMoreWork = false;
 
-    if(currentFileIdx < nFiles) {
-        *fileHandler = &files[currentFileIdx];
-        *fileIdx = currentFileIdx;
-        currentFileIdx++;
-        hasMoreWork = true;
+    while(currentFileIdx < nFiles && !hasMoreWork) {
+        FileHandler * fh = &files[currentFileIdx];
+        if(!fh->opened) {
+            open_file(fh);
+        }
+
+        if(fh->nextMatrix < fh->nMatrices) {
+            unsigned int rangeSize = BATCHES_PER_READ_RANGE * matrix_batch_size(fh->order);
+            unsigned int remaining = fh->nMatrices - fh->nextMatrix;
+
+            *fileHandler = fh;
+            *fileIdx = currentFileIdx;
+            *first = fh->nextMatrix;
+            *count = (remaining < rangeSize) ? remaining : rangeSize;
+            fh->nextMatrix += *count;
+            fh->nReading++;
+            hasMoreWork = true;
+        }
+        else {
+            // every range of the file was handed out
+            currentFileIdx++;
+        }
     }
 
     pthread_mutex_unlock(&mutex);
     return hasMoreWork;
-}
\ No newline at end of file
+}
+
+MatrixHandler * sm_getMatrixView(FileHandler * fileHandler, unsigned int matrixIdx) {
+    return &fileHandler->views[matrixIdx].handler;
+}
+
+unsigned int sm_getMatrixCount(unsigned int fileIdx) {
+    return files[fileIdx].nMatrices;
+}
+
+void sm_doneMatrixRange(unsigned int fileIdx) {
+    pthread_mutex_lock(&mutex);
+
+    FileHandler * fh = &files[fileIdx];
+    fh->nReading--;
+    if(fh->nReading == 0 && fh->nextMatrix == fh->nMatrices && fh->fd != -1) {
+        close(fh->fd);
+        fh->fd = -1;
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
@@ -2,6 +2,7 @@
 #define SHARED_MEMORY_H
 
 #include <stdbool.h>
+#include <sys/types.h>
 
 #include "fifo.h"
 
@@ -12,12 +13,37 @@
  * 
  */
 
-/** \brief Represents the FileHandler */
+/** \brief offset of a matrix in its file, after the number of matrices and the order */
+#define MATRIX_OFFSET(order, matrixIdx) (2 * sizeof(unsigned int) + (off_t) (matrixIdx) * (order) * (order) * sizeof(double))
+
+/** \brief Ways the matrices are taken from the files */
+enum MatrixSource {
+    READ_SOURCE,    /*!< matrices are read with pread into the slots of the pool of the file */
+    MMAP_SOURCE     /*!< files are mapped read-only, the computing workers get views of the matrices */
+};
+
+/** \brief View of a matrix of a mapped file */
+struct sMatrixView;
+
+/** \brief Represents the FileHandler
+ *
+ *  The header of the file is read by the first reader thread reaching it, the matrices are then
+ *  handed out to the reader threads in disjoint ranges read with pread on the same descriptor or,
+ *  with MMAP_SOURCE, taken straight from the mapping of the file.
+ */
 typedef struct sFileHandler {
     char * fileName;
     double * determinants;
     unsigned int nMatrices;
     unsigned int order;
+    bool opened;                    /*!< the header was read, fd and pool are set */
+    int fd;                         /*!< file descriptor, -1 once every range was read */
+    struct sMatrixPool * pool;      /*!< pool of the matrices of the file */
+    unsigned int nextMatrix;        /*!< first matrix not handed out to a reader yet */
+    unsigned int nReading;          /*!< ranges being read */
+    void * mapping;                 /*!< mapping of the file, MMAP_SOURCE only */
+    size_t mappingSize;             /*!< size of the mapping */
+    struct sMatrixView * views;     /*!< views of the matrices of the mapping */
 } FileHandler;
 
 
@@ -27,21 +53,60 @@ typedef struct sFileHandler {
  * 
  *  \param fileNames list of names of files
  *  \param fileCount files length
+ *  \param source way the matrices are taken from the files
  * 
  */
-void sm_init(char ** fileNames, unsigned int fileCount);
+void sm_init(char ** fileNames, unsigned int fileCount, enum MatrixSource source);
 
 
-/** \brief Fetches a File from the FileHandlers
+/** \brief Fetches a range of matrices to read
  * 
- *  Used by the file reader thread to fetch which file to read the matrices from
+ *  Used by the file reader threads. The files are handed out in order, each one in ranges of
+ *  BATCHES_PER_READ_RANGE batches of matrices, so that several threads read the same file at once.
+ *  The header of a file is read and its pool created when the first range of the file is fetched.
  * 
- *  \param[out] fileHandler Pointer to a FileHandler used in the worker thread
- *  \param[out] fileIdx Index of the current file
+ *  \param[out] fileHandler Pointer to the FileHandler of the file
+ *  \param[out] fileIdx Index of the file
+ *  \param[out] first Index of the first matrix of the range
+ *  \param[out] count Number of matrices of the range
  *  
  *  \return boolean representing True if there is more work for the thread or False if the thread can exit.
  */
-extern bool sm_getFile(FileHandler ** fileHandler, unsigned int * fileIdx);
+extern bool sm_getMatrixRange(FileHandler ** fileHandler, unsigned int * fileIdx, unsigned int * first, unsigned int * count);
+
+
+/** \brief Signals that a range of matrices was read
+ * 
+ *  Used by the file reader threads, the file is closed once its last range is read.
+ * 
+ *  \param fileIdx Index of the file
+ *  
+ */
+extern void sm_doneMatrixRange(unsigned int fileIdx);
+
+
+/** \brief Gets the view of a matrix of a mapped file
+ * 
+ *  Used by the file reader threads with MMAP_SOURCE. The view points into the read-only mapping of
+ *  the file and has no pool, the computing workers run the elimination on a copy.
+ * 
+ *  \param fileHandler FileHandler of the file
+ *  \param matrixIdx Index of the matrix in the file
+ *  
+ *  \return view of the matrix
+ */
+extern MatrixHandler * sm_getMatrixView(FileHandler * fileHandler, unsigned int matrixIdx);
+
+
+/** \brief Gets the number of matrices of a file
+ * 
+ *  Used by the determinant computing thread to choose how many threads compute a matrix.
+ * 
+ *  \param fileIdx Index of the file, its header was read
+ *  
+ *  \return number of matrices of the file
+ */
+extern unsigned int sm_getMatrixCount(unsigned int fileIdx);
 
 
 /** \brief Adds a MatrixHandler to the Fifo
@@ -1 +1 @@
-mpicc -Wall src/main.c src/fifo.c src/textFiles.c src/utf8.c -o main -lpthread
\ No newline at end of file
+mpicc -Wall src/main.c src/fifo.c src/fifo_monitor.c src/textFiles.c src/fileRanges.c src/workerPool.c src/utf8.c src/wordScanner.c -o main -lpthread
\ No newline at end of file
@@ -1,160 +1,263 @@
-#include <stdlib.h>
-#include <stdbool.h>
-#include <unistd.h>
-#include <pthread.h>
-#include <errno.h>
-#include "fifo.h"
-
 /**
  *  \file fifo.c implementation
  *
  *  \brief Fifo that store data chunks to be processed.
  *
+ *  Lock-free bounded multi-producer / multi-consumer queue (D. Vyukov).
+ *
+ *  Every cell of the ring holds a sequence number. A producer may fill the cell at position pos when
+ *  its sequence is pos, a consumer may empty it when its sequence is pos + 1. Producers and consumers
+ *  claim positions with a compare-and-swap on their own counter and publish the cell by storing its
+ *  next sequence, so neither side takes a lock.
+ *
+ *  Threads that find the queue full (producers) or empty (consumers) spin for FIFO_SPIN_COUNT tries
+ *  and then park on a futex, woken only when the other side has registered sleepers. On a single
+ *  processor spinning only delays the thread that would make progress, so threads park at once.
+ *
+ *  Definition of the operations carried out by the reading thread / proxy threads:
+ *     \li putChunk
+ *     \li getChunk
+ *     \li doneReading.
+ *
  *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
  */
 
-/** \brief reading thread return status */
-extern int statusReadingThread;
+#ifndef FIFO_MONITOR
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#include "fifo.h"
+
+/** \brief number of tries before parking on the futex */
+#define FIFO_SPIN_COUNT 128
 
-/** \brief proxy threads return status */
-extern int * statusProxyThread;
+/** \brief size of a cache line, the counters of producers and consumers never share one */
+#define CACHE_LINE_SIZE 64
+
+/** \brief Cell of the ring */
+struct sCell {
+    atomic_size_t sequence;         /*!< position the cell is ready for, pos to be filled, pos + 1 to be emptied */
+    Chunk * value;          /*!< stored value */
+};
 
 /** \brief storage region */
-static Chunk * mem[FIFO_MAX_SIZE];
+static struct sCell mem[FIFO_MAX_SIZE];
+
+/** \brief insertion position */
+static _Alignas(CACHE_LINE_SIZE) atomic_size_t ii;
 
-/** \brief insertion pointer */
-static unsigned int ii;
+/** \brief retrieval position */
+static _Alignas(CACHE_LINE_SIZE) atomic_size_t ri;
 
-/** \brief retrieval pointer */
-static unsigned int ri;
+/** \brief futex word of the consumers, incremented whenever a value is stored or reading is done */
+static _Alignas(CACHE_LINE_SIZE) atomic_uint valueStored;
 
-/** \brief flag signaling the data transfer region is full */
-static bool full;
+/** \brief number of consumers parked on valueStored */
+static atomic_uint sleepingConsumers;
 
-/** \brief locking flag which warrants mutual exclusion inside the monitor */
-static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
+/** \brief futex word of the producers, incremented whenever a value is retrieved */
+static _Alignas(CACHE_LINE_SIZE) atomic_uint valueRetrieved;
 
-/** \brief flag which warrants that the data transfer region is initialized exactly once */
-static pthread_once_t init = PTHREAD_ONCE_INIT;;
+/** \brief number of producers parked on valueRetrieved */
+static atomic_uint sleepingProducers;
 
-/** \brief producers synchronization point when the data transfer region is full */
-static pthread_cond_t fifoFull;
+/** \brief represents that there are not more chunks to be inserted */
+static atomic_bool blockPuts = false;
 
-/** \brief consumers synchronization point when the data transfer region is empty */
-static pthread_cond_t fifoEmpty;
+/** \brief number of tries before parking, 0 on a single processor */
+static int spinCount;
 
-/** \brief Signals when all the data chunks have been read */
-static bool done = false;
+/** \brief the sequence numbers are initialized exactly once */
+static pthread_once_t init = PTHREAD_ONCE_INIT;
 
 /**
  *  \brief Initialization of the data transfer region.
  *
- *  Internal monitor operation.
+ *  Internal operation.
  */
 
 static void initialization (void)
 {
-                                                                                   /* initialize FIFO in empty state */
-  ii = ri = 0;                                        /* FIFO insertion and retrieval pointers set to the same value */
-  full = false;                                                                                  /* FIFO is not full */
+  for (size_t i = 0; i < FIFO_MAX_SIZE; i++)
+    atomic_store_explicit (&mem[i].sequence, i, memory_order_relaxed);
+  atomic_store (&ii, 0);
+  atomic_store (&ri, 0);
+  spinCount = (sysconf (_SC_NPROCESSORS_ONLN) > 1) ? FIFO_SPIN_COUNT : 0;
+}
+
+/** \brief Parks the calling thread while the futex word keeps the given value */
+static void futexWait (atomic_uint *word, unsigned int value)
+{
+  syscall (SYS_futex, (uint32_t *) word, FUTEX_WAIT_PRIVATE, value, NULL, NULL, 0);
+}
+
+/** \brief Wakes up to n threads parked on the futex word */
+static void futexWake (atomic_uint *word, int n)
+{
+  syscall (SYS_futex, (uint32_t *) word, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+/** \brief Pause inside a spinning loop */
+static inline void cpuRelax (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause ();
+#endif
+}
+
+/**
+ *  \brief Tries to store a value.
+ *
+ *  \param val value to be stored
+ *
+ *  \return true if the value was stored, false if the fifo is full
+ */
 
-  pthread_cond_init (&fifoFull, NULL);                                 /* initialize producers synchronization point */
-  pthread_cond_init (&fifoEmpty, NULL);                                /* initialize consumers synchronization point */
+static bool tryPut (Chunk * val)
+{
+  size_t pos = atomic_load_explicit (&ii, memory_order_relaxed);
+  while (true)
+  { struct sCell *cell = &mem[pos % FIFO_MAX_SIZE];
+    size_t sequence = atomic_load_explicit (&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) pos;
+    if (diff == 0)                                                                       /* the cell is empty, claim it */
+    { if (atomic_compare_exchange_weak_explicit (&ii, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+      { cell->value = val;
+        atomic_store_explicit (&cell->sequence, pos + 1, memory_order_release);           /* publish it to consumers */
+        return true;
+      }
+    }
+    else if (diff < 0)                                                   /* the cell was not emptied yet, fifo is full */
+      return false;
+    else pos = atomic_load_explicit (&ii, memory_order_relaxed);                  /* another producer took the cell */
+  }
 }
 
+/**
+ *  \brief Tries to retrieve a value.
+ *
+ *  \param val retrieved value
+ *
+ *  \return true if a value was retrieved, false if the fifo is empty
+ */
 
+static bool tryGet (Chunk ** val)
+{
+  size_t pos = atomic_load_explicit (&ri, memory_order_relaxed);
+  while (true)
+  { struct sCell *cell = &mem[pos % FIFO_MAX_SIZE];
+    size_t sequence = atomic_load_explicit (&cell->sequence, memory_order_acquire);
+    intptr_t diff = (intptr_t) sequence - (intptr_t) (pos + 1);
+    if (diff == 0)                                                                        /* the cell is full, claim it */
+    { if (atomic_compare_exchange_weak_explicit (&ri, &pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+      { *val = cell->value;
+        atomic_store_explicit (&cell->sequence, pos + FIFO_MAX_SIZE, memory_order_release);  /* ready for next lap */
+        return true;
+      }
+    }
+    else if (diff < 0)                                                  /* the cell was not filled yet, fifo is empty */
+      return false;
+    else pos = atomic_load_explicit (&ri, memory_order_relaxed);                  /* another consumer took the cell */
+  }
+}
 
 void doneReading() {
-  pthread_mutex_lock (&accessCR);
-  done = true;
-  pthread_cond_broadcast (&fifoEmpty);
-  pthread_mutex_unlock (&accessCR);
+  pthread_once (&init, initialization);
+  atomic_store (&blockPuts, true);
+  atomic_fetch_add (&valueStored, 1);
+  futexWake (&valueStored, INT_MAX);
 }
 
-void putChunk(Chunk * data)
+/**
+ *  \brief Store a value in the data transfer region.
+ *
+ *  Operation carried out by the reading thread.
+ *
+ *  \param val value to be stored
+ */
+
+void putChunk(Chunk * val)
 {
-  if ((statusReadingThread = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
-     { errno = statusReadingThread;                                                            /* save error in errno */
-       perror ("error on entering monitor(CF)");
-       statusReadingThread = EXIT_FAILURE;
-       pthread_exit (&statusReadingThread);
-     }
   pthread_once (&init, initialization);                                              /* internal data initialization */
-  
-
-  while (full)                                                           /* wait if the data transfer region is full */
-  { if ((statusReadingThread = pthread_cond_wait (&fifoFull, &accessCR)) != 0)
-       { errno = statusReadingThread;                                                          /* save error in errno */
-         perror ("error on waiting in fifoFull");
-         statusReadingThread = EXIT_FAILURE;
-         pthread_exit (&statusReadingThread);
-       }
-  }
 
-  mem[ii] = data;
-  ii = (ii + 1) % FIFO_MAX_SIZE;
-  full = (ii == ri);
+  for (int spin = 0; !tryPut (val); spin++)                                       /* wait if the fifo is full */
+  { if (spin < spinCount)
+    { cpuRelax ();
+      continue;
+    }
+
+    unsigned int event = atomic_load (&valueRetrieved);
+    atomic_fetch_add (&sleepingProducers, 1);
+    atomic_thread_fence (memory_order_seq_cst);
+    if (tryPut (val))                                               /* a value was retrieved before parking */
+    { atomic_fetch_sub (&sleepingProducers, 1);
+      break;
+    }
+    futexWait (&valueRetrieved, event);
+    atomic_fetch_sub (&sleepingProducers, 1);
+  }
 
-  if ((statusReadingThread = pthread_cond_signal (&fifoEmpty)) != 0)      /* let a consumer know that a value has been
+  atomic_fetch_add (&valueStored, 1);                                   /* let a consumer know that a value has been
                                                                                                                stored */
-     { errno = statusReadingThread;                                                             /* save error in errno */
-       perror ("error on signaling in fifoEmpty");
-       statusReadingThread = EXIT_FAILURE;
-       pthread_exit (&statusReadingThread);
-     }
-
-  if ((statusReadingThread = pthread_mutex_unlock (&accessCR)) != 0)                                  /* exit monitor */
-     { errno = statusReadingThread;                                                            /* save error in errno */
-       perror ("error on exiting monitor(CF)");
-       statusReadingThread = EXIT_FAILURE;
-       pthread_exit (&statusReadingThread);
-     }
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load (&sleepingConsumers) > 0)
+    futexWake (&valueStored, 1);
 }
 
-bool getChunk(unsigned int proxyId, Chunk **data)
-{
+/**
+ *  \brief Get a value from the data transfer region.
+ *
+ *  Operation carried out by the proxy threads.
+ *
+ *  \param proxyId proxy thread identification
+ *  \param val retrieved value
+ *
+ *  \return true if a value was retrieved, false if the fifo is empty and reading is done
+ */
 
-  if ((statusProxyThread[proxyId] = pthread_mutex_lock (&accessCR)) != 0)                                   /* enter monitor */
-     { errno = statusProxyThread[proxyId];                                                            /* save error in errno */
-       perror ("error on entering monitor(CF)");
-       statusProxyThread[proxyId] = EXIT_FAILURE;
-       pthread_exit (&statusProxyThread[proxyId]);
-     }
+bool getChunk(unsigned int proxyId, Chunk ** val)
+{
   pthread_once (&init, initialization);                                              /* internal data initialization */
 
-  while ((ii == ri) && !full)                                           /* wait if the data transfer region is empty */
-  { 
-    if(done) {
-      pthread_mutex_unlock (&accessCR);
+  for (int spin = 0; !tryGet (val); spin++)                                      /* wait if the fifo is empty */
+  { if (atomic_load (&blockPuts))                      /* every value was stored before reading was signaled done */
+    { if (tryGet (val))
+        break;
       return false;
     }
-    if ((statusProxyThread[proxyId] = pthread_cond_wait (&fifoEmpty, &accessCR)) != 0)
-       {
-         errno = statusProxyThread[proxyId];                                                          /* save error in errno */
-         perror ("error on waiting in fifoEmpty");
-         statusProxyThread[proxyId] = EXIT_FAILURE;
-         pthread_exit (&statusProxyThread[proxyId]);
-       }
-  }
+    if (spin < spinCount)
+    { cpuRelax ();
+      continue;
+    }
 
-  *data = mem[ri];                                                                   /* retrieve a  value from the FIFO */
-  ri = (ri + 1) % FIFO_MAX_SIZE;
-  full = false;
+    unsigned int event = atomic_load (&valueStored);
+    atomic_fetch_add (&sleepingConsumers, 1);
+    atomic_thread_fence (memory_order_seq_cst);
+    if (tryGet (val))                                                  /* a value was stored before parking */
+    { atomic_fetch_sub (&sleepingConsumers, 1);
+      break;
+    }
+    if (!atomic_load (&blockPuts))
+      futexWait (&valueStored, event);
+    atomic_fetch_sub (&sleepingConsumers, 1);
+  }
 
-  if ((statusProxyThread[proxyId] = pthread_cond_signal (&fifoFull)) != 0)       /* let a producer know that a value has been
+  atomic_fetch_add (&valueRetrieved, 1);                               /* let a producer know that a value has been
                                                                                                             retrieved */
-     { errno = statusProxyThread[proxyId];                                                             /* save error in errno */
-       perror ("error on signaling in fifoFull");
-       statusProxyThread[proxyId] = EXIT_FAILURE;
-       pthread_exit (&statusProxyThread[proxyId]);
-     }
-
-  if ((statusProxyThread[proxyId] = pthread_mutex_unlock (&accessCR)) != 0)                                   /* exit monitor */
-     { errno = statusProxyThread[proxyId];                                                             /* save error in errno */
-       perror ("error on exiting monitor(CF)");
-       statusProxyThread[proxyId] = EXIT_FAILURE;
-       pthread_exit (&statusProxyThread[proxyId]);
-     }
+  atomic_thread_fence (memory_order_seq_cst);
+  if (atomic_load (&sleepingProducers) > 0)
+    futexWake (&valueRetrieved, 1);
 
   return true;
 }
+
+#endif /* FIFO_MONITOR */
@@ -17,7 +17,8 @@
 /** \brief Data chunk process by a worker a respective file handler */
 struct sChunk
 {
-    uint8_t data[DATA_BUFFER_SIZE];
+    uint8_t *data; /*!< Buffer of chunkSize bytes */
+    uint32_t size; /*!< Number of bytes of data used */
     FileHandler handler;
     Result result; /*!< Number of words ending in consoant */
                    /*!< Number of words beginning in vowel */
@@ -0,0 +1,173 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "fileRanges.h"
+#include "utf8.h"
+#include "workerPool.h"
+
+/**
+ *  \file fileRanges.c
+ *
+ *  \brief File ranges implementation
+ *
+ *  Counting of the words of a file split among the ranks without dispatcher.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
+ */
+
+/** \brief bytes looked at a time for the delimiter ending a range */
+#define ALIGN_WINDOW_SIZE 64
+
+/** \brief Reads bytes of a file at the given offset
+ *
+ *  \returns number of bytes read, less than size at the end of the file, -1 on error
+ */
+static int readAt(MPI_File file, MPI_Offset offset, uint8_t *data, int size)
+{
+    MPI_Status status;
+    int count;
+    if (MPI_File_read_at(file, offset, data, size, MPI_UINT8_T, &status) != MPI_SUCCESS)
+        return -1;
+    MPI_Get_count(&status, MPI_UINT8_T, &count);
+    return count;
+}
+
+/** \brief Moves a position of a file to right after the next delimiter
+ *
+ *  If the position is in the middle of a character the search begins at the next one.
+ *
+ *  \param file file being processed
+ *  \param fileSize size of the file
+ *  \param[in,out] pos position, the size of the file if there is no delimiter after it
+ *
+ *  \returns FAILURE If an error occurs, otherwise SUCCESS
+ */
+static int alignToDelimiter(MPI_File file, MPI_Offset fileSize, MPI_Offset *pos)
+{
+    //a character beginning in the window may end 3 bytes after it
+    uint8_t window[ALIGN_WINDOW_SIZE + 3];
+    MPI_Offset offset = *pos;
+
+    while (offset < fileSize)
+    {
+        int n = readAt(file, offset, window, sizeof(window));
+        if (n <= 0)
+            return FAILURE;
+
+        int i = 0;
+        while (i < n && i < ALIGN_WINDOW_SIZE)
+        {
+            //skip continuation bytes of the current character
+            if ((window[i] & 0xC0) == 0x80)
+            {
+                i++;
+                continue;
+            }
+
+            int characterSize = getUTF8CharSize(window[i]);
+            if (characterSize == 0)
+                characterSize = 1;
+            if (i + characterSize > n) //truncated character at the end of the file
+            {
+                *pos = fileSize;
+                return SUCCESS;
+            }
+
+            unsigned int utf8Char = window[i];
+            for (int j = 1; j < characterSize; j++)
+                utf8Char = (utf8Char << 8) | window[i + j];
+
+            i += characterSize;
+            if (getUTF8CharType(utf8Char) == DELIMITER)
+            {
+                *pos = offset + i;
+                return SUCCESS;
+            }
+        }
+        offset += i;
+    }
+
+    *pos = fileSize;
+    return SUCCESS;
+}
+
+/** \brief Finds the end of the last delimiter of a buffer
+ *
+ *  \returns position right after the last delimiter, size if there is none
+ */
+static int lastDelimiterEnd(const uint8_t *data, int size)
+{
+    for (int pos = size - 1; pos >= 0; pos--)
+    {
+        int characterSize = getUTF8CharSize(data[pos]);
+        if (characterSize == 0 || pos + characterSize > size) //continuation byte or character cut by the buffer
+            continue;
+
+        unsigned int utf8Char = data[pos];
+        for (int i = 1; i < characterSize; i++)
+            utf8Char = (utf8Char << 8) | data[pos + i];
+
+        if (getUTF8CharType(utf8Char) == DELIMITER)
+            return pos + characterSize;
+    }
+    return size;
+}
+
+int fr_countRange(const char *fileName, MPI_Offset fileSize, int rank, int nRanks, Result result)
+{
+    result[0] = 0; //Number of words ending in consoant
+    result[1] = 0; //Number of words beginning in vowel
+    result[2] = 0; //Total number of words
+
+    MPI_File file;
+    if (MPI_File_open(MPI_COMM_SELF, fileName, MPI_MODE_RDONLY, MPI_INFO_NULL, &file) != MPI_SUCCESS)
+    {
+        fprintf(stderr, "Error opening file %s\n", fileName);
+        return FAILURE;
+    }
+
+    //both ends move to right after the next delimiter, the previous rank ends where this one begins
+    MPI_Offset begin = fileSize * rank / nRanks;
+    MPI_Offset end = fileSize * (rank + 1) / nRanks;
+    if ((begin > 0 && alignToDelimiter(file, fileSize, &begin) == FAILURE) ||
+        (end < fileSize && alignToDelimiter(file, fileSize, &end) == FAILURE))
+    {
+        fprintf(stderr, "Error on reading file %s\n", fileName);
+        MPI_File_close(&file);
+        return FAILURE;
+    }
+
+    uint8_t *data = NULL;
+    if (begin < end && (data = (uint8_t *) malloc(RANGE_BUFFER_SIZE)) == NULL)
+    {
+        perror("malloc error");
+        MPI_File_close(&file);
+        return FAILURE;
+    }
+
+    int status = SUCCESS;
+    while (begin < end)
+    {
+        int size = (end - begin < RANGE_BUFFER_SIZE) ? (int) (end - begin) : RANGE_BUFFER_SIZE;
+        if (readAt(file, begin, data, size) != size)
+        {
+            fprintf(stderr, "Error on reading file %s\n", fileName);
+            status = FAILURE;
+            break;
+        }
+
+        //the bytes after the last delimiter are read again with the next buffer
+        if (begin + size < end)
+            size = lastDelimiterEnd(data, size);
+
+        Result count;
+        wp_processChunk(data, size, count);
+        result[0] += count[0];
+        result[1] += count[1];
+        result[2] += count[2];
+        begin += size;
+    }
+
+    free(data);
+    MPI_File_close(&file);
+    return status;
+}
@@ -0,0 +1,36 @@
+#ifndef FILE_RANGES_H
+#define FILE_RANGES_H
+
+#include <mpi.h>
+#include "probConst.h"
+#include "textFiles.h"
+
+/**
+ *  \file fileRanges.h
+ *
+ *  \brief File ranges header
+ *
+ *  Counting of the words of a file split among the ranks without dispatcher. Each rank reads its own
+ *  range of the file with MPI_File_read_at: the file is split in equal ranges whose ends are moved to
+ *  right after the next delimiter, the same position for the rank ending at it and the rank beginning
+ *  at it, so that every word is counted by a single rank. The blocks read are counted by the worker
+ *  pool of the rank.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
+ */
+
+/** \brief Counts the words of the range of a file given to a rank
+ *
+ *  \param fileName name of the file
+ *  \param fileSize size of the file in bytes
+ *  \param rank rank counting the range
+ *  \param nRanks number of ranks the file is split among
+ *  \param[out] result counting results of the range
+ *
+ *  \returns FAILURE If an error occurs, otherwise SUCCESS
+ *  \sa FAILURE
+ *  \sa SUCCESS
+ */
+int fr_countRange(const char *fileName, MPI_Offset fileSize, int rank, int nRanks, Result result);
+
+#endif /* FILE_RANGES_H */
@@ -4,10 +4,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "probConst.h"
 #include "textFiles.h"
 #include "utf8.h"
 #include "fifo.h"
+#include "fileRanges.h"
+#include "workerPool.h"
 
 /**
  *  \file main.c
@@ -17,6 +21,10 @@
  *  This program reads in succession several text files text#.txt whose names are provided in
  *  the command line and prints a listing of total number of words, number of words beginning with a
  *  vowel and number of words ending with a consonant for each of the supplied files.
+ *
+ *  By default rank 0 reads the files and dispatches their chunks to the other ranks. With -r every
+ *  rank reads its own range of each file and the counts are summed at rank 0. With -t every rank counts
+ *  with several threads, and in the dispatcher mode receives chunks as many times larger.
  *  
  *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
  */
@@ -27,31 +35,40 @@ int statusReadingThread;
 /** \brief Proxy threads return status */
 int * statusProxyThread;
 
-/** \brief Gives the couting results of a given chunk of data */
-void processChunkOfData(uint8_t data[DATA_BUFFER_SIZE], uint16_t dataSize, Result result);
+/** \brief Size of the chunks of data sent to a worker, DATA_BUFFER_SIZE for each of its threads */
+uint32_t chunkSize = DATA_BUFFER_SIZE;
+
+/** \brief Gives the couting results of a given chunk of data, counted by the worker pool of the rank */
+void processChunkOfData(uint8_t *data, uint32_t dataSize, Result result);
 
 /** \brief Execution code of file reader thread*/
 void *codeReadingThread(void *args);
 
-/** \brief Execution code of proxy thread */
+/** \brief Execution code of proxy thread
+ *
+ *  Keeps up to CHUNKS_IN_FLIGHT chunks sent to its worker, the chunk of a result is the one sent on
+ *  the same tag.
+ */
 void *codeProxyThread(void *args);
 
 /** \brief Send termination condition message to the target worker */
 void sendTerminationCondition(unsigned int workerId);
 
+/** \brief Counts the words of the files without dispatcher, each rank reading its own ranges
+ *
+ *  Rank 0 gives every rank the names and sizes of the files, every rank counts its range of each file
+ *  and the counts of a file are summed at rank 0, which prints them.
+ *
+ *  \returns FAILURE If an error occurs in any rank, otherwise SUCCESS
+ */
+int countWordsByRanges(int rank, int nProc, int nFiles, char *files[], char fileNames[nFiles][MAX_FILE_NAME_SIZE]);
+
+/** \brief Prints the counting results of every file */
+void printResults(int nFiles, char fileNames[nFiles][MAX_FILE_NAME_SIZE], Result results[nFiles]);
+
 int main(int argc, char *argv[])
 {
-    // validate input arguments
-    if (argc == 1)
-    {
-        fprintf(stderr, "USAGE: ./countWords fileName [fileName ...]\n");
-        MPI_Finalize();
-        exit(EXIT_FAILURE);
-    }
-
     int rank, nProc, nWorkers;
-    int nFiles = argc - 1;
-    char fileNames[nFiles][MAX_FILE_NAME_SIZE];
     int provided;
 
     // Determine inialization time
@@ -68,7 +85,54 @@ int main(int argc, char *argv[])
     }
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     MPI_Comm_size(MPI_COMM_WORLD, &nProc);
-    
+
+    // validate input arguments
+    bool readRanges = false;
+    int threadsPerRank = 1;
+    int opt;
+    opterr = (rank == 0);
+    while ((opt = getopt(argc, argv, "rt:h")) != -1)
+    {
+        if (opt == 'r')
+            readRanges = true;
+        else if (opt == 't' && (threadsPerRank = atoi(optarg)) >= 1 && threadsPerRank <= MAX_THREADS_PER_RANK)
+            chunkSize = DATA_BUFFER_SIZE * threadsPerRank;
+        else
+        {
+            if (rank == 0)
+                fprintf(stderr, "USAGE: ./countWords [-r] [-t threads] fileName [fileName ...]\n"
+                                "  -r   every rank reads its own range of the files, no dispatcher\n"
+                                "  -t   number of threads counting in every rank, 1 to %d (default: 1)\n", MAX_THREADS_PER_RANK);
+            MPI_Finalize();
+            exit(opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE);
+        }
+    }
+
+    int nFiles = argc - optind;
+    if (nFiles == 0)
+    {
+        if (rank == 0)
+            fprintf(stderr, "USAGE: ./countWords [-r] [-t threads] fileName [fileName ...]\n");
+        MPI_Finalize();
+        exit(EXIT_FAILURE);
+    }
+    char fileNames[nFiles][MAX_FILE_NAME_SIZE];
+
+    // every rank counting words has its pool of threads, the dispatcher does not count
+    if ((readRanges || rank != 0) && wp_initialize(threadsPerRank) == FAILURE)
+    {
+        fprintf(stderr, "Failed to start the worker pool of rank %d\n", rank);
+        MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+    }
+
+    if (readRanges)
+    {
+        int status = countWordsByRanges(rank, nProc, nFiles, argv + optind, fileNames);
+        wp_close();
+        MPI_Finalize();
+        exit(status == SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+
     if (nProc <= 1)
     {
         if (rank == 0)
@@ -86,7 +150,7 @@ int main(int argc, char *argv[])
         // parseFiles
         for (int i = 0; i < nFiles; i++)
         {
-            if (strlen(argv[i + 1]) > MAX_FILE_NAME_SIZE)
+            if (strlen(argv[optind + i]) >= MAX_FILE_NAME_SIZE)
             {
                 fprintf(stderr, "File path is too long!\n");
                 for(int n = 1; n <= nWorkers; n++)
@@ -94,7 +158,7 @@ int main(int argc, char *argv[])
                 MPI_Finalize();
                 exit(EXIT_FAILURE);
             }
-            strcpy(fileNames[i], argv[i + 1]);
+            strcpy(fileNames[i], argv[optind + i]);
         }
 
         int status = tf_initialize(nFiles, fileNames);
@@ -197,15 +261,7 @@ int main(int argc, char *argv[])
         {
             Result results[nFiles];
             tf_getResults(results);
-            for (int i = 0; i < nFiles; i++)
-            {
-                fprintf(stdout,
-                        "\nFile name: %s\n"
-                        "Total number of words = %d\n"
-                        "N. of words beginning with a vowel = %d\n"
-                        "N. of words ending with a consonant = %d\n",
-                        fileNames[i], results[i][2], results[i][1], results[i][0]);
-            }
+            printResults(nFiles, fileNames, results);
         }
         else
         {
@@ -220,124 +276,110 @@ int main(int argc, char *argv[])
     //------------------------
     else
     {
-        Result result;
-        uint8_t data[DATA_BUFFER_SIZE];
+        // chunks are received with their own size, the buffer grows with them
+        uint8_t *data = NULL;
+        int capacity = 0;
+        Result results[CHUNKS_IN_FLIGHT];
+        MPI_Request sendRequests[CHUNKS_IN_FLIGHT];
+        for (int tag = 0; tag < CHUNKS_IN_FLIGHT; tag++)
+            sendRequests[tag] = MPI_REQUEST_NULL;
 
         while (true)
         {
-            MPI_Recv((void *)data, DATA_BUFFER_SIZE, MPI_UINT8_T, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-            uint16_t dataSize = (((uint16_t)data[DATA_BUFFER_SIZE - 1]) << 8) | ((uint16_t)data[DATA_BUFFER_SIZE - 2]);
+            MPI_Status status;
+            MPI_Probe(0, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
             // Check is there is more work to do
-            if (dataSize == 0x0000)
+            if (status.MPI_TAG == TERMINATION_TAG)
+            {
+                MPI_Recv(NULL, 0, MPI_UINT8_T, 0, TERMINATION_TAG, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
                 break;
+            }
 
-            processChunkOfData(data, dataSize, result);
-            MPI_Send((void *)result, 3, MPI_UINT32_T, 0, 0, MPI_COMM_WORLD);
+            int dataSize;
+            MPI_Get_count(&status, MPI_UINT8_T, &dataSize);
+            if (dataSize > capacity)
+            {
+                capacity = dataSize;
+                if ((data = (uint8_t *)realloc(data, capacity)) == NULL)
+                {
+                    fprintf(stderr, "Failed to allocate chunk buffer\n");
+                    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+                }
+            }
+            int tag = status.MPI_TAG;
+            MPI_Recv((void *)data, dataSize, MPI_UINT8_T, 0, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+
+            // the previous result of the tag must be gone before its buffer is reused
+            MPI_Wait(&sendRequests[tag], MPI_STATUS_IGNORE);
+            processChunkOfData(data, dataSize, results[tag]);
+            MPI_Isend((void *)results[tag], 3, MPI_UINT32_T, 0, tag, MPI_COMM_WORLD, &sendRequests[tag]);
         }
+        MPI_Waitall(CHUNKS_IN_FLIGHT, sendRequests, MPI_STATUSES_IGNORE);
+        free(data);
+        wp_close();
     }
 
     MPI_Finalize();
     exit(EXIT_SUCCESS);
 }
 
-void processChunkOfData(uint8_t data[DATA_BUFFER_SIZE], uint16_t dataSize, Result result)
+void processChunkOfData(uint8_t *data, uint32_t dataSize, Result result)
 {
     // process Chunk of data
-    unsigned int totalWordsEndingInConsoant = 0;
-    unsigned int totalWordsBeginningInVowel = 0;
-    unsigned int totalWords = 0;
-
-    enum CharacterType charType;
-    enum CharacterType lastCharType;
-    bool inWord = false;
-
-    unsigned int utf8Char;
-    int utf8CharSize;
-    int dataIdx = 0;
-    // Block of text
-    do
-    {
-        utf8Char = data[dataIdx];
-        utf8CharSize = getUTF8CharSize(data[dataIdx]);
-
-        for (int i = 1; i < utf8CharSize; i++)
-        {
-            utf8Char = (utf8Char << 8) | data[dataIdx + i];
-        }
-        dataIdx += utf8CharSize;
-        charType = getUTF8CharType(utf8Char);
-
-        switch (inWord)
-        {
-        case false:
-            switch (charType)
-            {
-            case VOWEL:
-                totalWordsBeginningInVowel++;
-            case CONSOANT:
-            case UNDERSCORE:
-            case DIGIT:
-                totalWords++;
-                inWord = true;
-                break;
-
-            default:
-                break;
-            }
-
-            break;
-
-        case true:
-            switch (charType)
-            {
-            case DELIMITER:
-                if (lastCharType == CONSOANT)
-                    totalWordsEndingInConsoant++;
-
-                inWord = false;
-                break;
-
-            default:
-                break;
-            }
-            break;
-        }
-        if (charType != NOT_DEFINED) // ignore case NOT_DEFINED
-            lastCharType = charType;
-
-    } while (dataIdx < dataSize);
-
-    result[0] = totalWordsEndingInConsoant;
-    result[1] = totalWordsBeginningInVowel;
-    result[2] = totalWords;
+    wp_processChunk(data, dataSize, result);
 }
 
 void *codeProxyThread(void *args)
 {
-    Chunk * dataChunk;
     unsigned int workerId = *((int *)args);
 
-    while (true)
+    // chunk sent on each tag, NULL if the tag is free
+    Chunk * inFlight[CHUNKS_IN_FLIGHT];
+    MPI_Request sendRequests[CHUNKS_IN_FLIGHT], recvRequests[CHUNKS_IN_FLIGHT];
+    for (int tag = 0; tag < CHUNKS_IN_FLIGHT; tag++)
     {
-        int moreChunk = getChunk(workerId, &dataChunk);
+        inFlight[tag] = NULL;
+        sendRequests[tag] = recvRequests[tag] = MPI_REQUEST_NULL;
+    }
 
-        if (!moreChunk)
+    int nInFlight = 0;
+    bool moreChunks = true;
+    while (true)
+    {
+        // keep the worker busy, send chunks on the free tags
+        for (int tag = 0; moreChunks && tag < CHUNKS_IN_FLIGHT; tag++)
         {
-            sendTerminationCondition(workerId);
-            break;
+            if (inFlight[tag] != NULL)
+                continue;
+
+            Chunk * dataChunk;
+            if (!(moreChunks = getChunk(workerId, &dataChunk)))
+                break;
+
+            MPI_Isend((void *)dataChunk->data, dataChunk->size, MPI_UINT8_T, workerId, tag, MPI_COMM_WORLD, &sendRequests[tag]);
+            MPI_Irecv((void *)dataChunk->result, 3, MPI_UINT32_T, workerId, tag, MPI_COMM_WORLD, &recvRequests[tag]);
+            inFlight[tag] = dataChunk;
+            nInFlight++;
         }
 
-        // send data chunk
-        MPI_Send((void *)dataChunk->data, DATA_BUFFER_SIZE, MPI_UINT8_T, workerId, 0, MPI_COMM_WORLD);
+        if (nInFlight == 0)
+            break;
+
+        // receive any result, its tag tells the chunk it belongs to
+        int tag;
+        MPI_Waitany(CHUNKS_IN_FLIGHT, recvRequests, &tag, MPI_STATUS_IGNORE);
+        MPI_Wait(&sendRequests[tag], MPI_STATUS_IGNORE);
 
-        // receive result
-        MPI_Recv((void *)dataChunk->result, 3, MPI_UINT32_T, workerId, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
-        
-        tf_registerResult(dataChunk->handler, dataChunk->result);
-        free(dataChunk);
+        tf_registerResult(inFlight[tag]->handler, inFlight[tag]->result);
+        free(inFlight[tag]->data);
+        free(inFlight[tag]);
+        inFlight[tag] = NULL;
+        nInFlight--;
     }
-    statusProxyThread[workerId] = EXIT_SUCCESS;
-    pthread_exit(&statusProxyThread[workerId]);
+
+    sendTerminationCondition(workerId);
+    statusProxyThread[workerId - 1] = EXIT_SUCCESS;
+    pthread_exit(&statusProxyThread[workerId - 1]);
 }
 
 void *codeReadingThread(void *args)
@@ -347,7 +389,15 @@ void *codeReadingThread(void *args)
     while (moreChunks)
     {
         Chunk *dataChunk = (Chunk *)malloc(sizeof(Chunk));
-        int status = tf_readChunk(dataChunk->data, &(dataChunk->handler), &moreChunks);
+        if (dataChunk == NULL || (dataChunk->data = (uint8_t *)malloc(chunkSize)) == NULL)
+        {
+            fprintf(stderr, "Failed to allocate data chunk!\n");
+            doneReading();
+            statusReadingThread = EXIT_FAILURE;
+            pthread_exit(&statusReadingThread);
+        }
+
+        int status = tf_readChunk(dataChunk->data, chunkSize, &(dataChunk->size), &(dataChunk->handler), &moreChunks);
         if (status == FAILURE)
         {
             fprintf(stderr, "Error reading data chunk!\n");
@@ -358,6 +408,11 @@ void *codeReadingThread(void *args)
 
         if (moreChunks)
             putChunk(dataChunk);
+        else
+        {
+            free(dataChunk->data);
+            free(dataChunk);
+        }
     }
 
     doneReading();
@@ -367,10 +422,80 @@ void *codeReadingThread(void *args)
 
 void sendTerminationCondition(unsigned int workerId)
 {
-    // Send termination condition, i.e., dataChunk size 0x0000
-    uint8_t finish[DATA_BUFFER_SIZE];
-    finish[DATA_BUFFER_SIZE - 2] = 0x00;
-    finish[DATA_BUFFER_SIZE - 1] = 0x00;
+    // Send termination condition, i.e., an empty message on its own tag
+    MPI_Send(NULL, 0, MPI_UINT8_T, workerId, TERMINATION_TAG, MPI_COMM_WORLD);
+}
+
+int countWordsByRanges(int rank, int nProc, int nFiles, char *files[], char fileNames[nFiles][MAX_FILE_NAME_SIZE])
+{
+    // Determine executing start time
+    struct timespec startTime, endTime;
+    clock_gettime(CLOCK_MONOTONIC, &startTime);
 
-    MPI_Send((void *)finish, DATA_BUFFER_SIZE, MPI_UINT8_T, workerId, 0, MPI_COMM_WORLD);
+    // rank 0 gives the names and sizes of the files, -1 for a file that can not be read
+    long long fileSizes[nFiles];
+    if (rank == 0)
+    {
+        for (int i = 0; i < nFiles; i++)
+        {
+            struct stat fileStat;
+            fileSizes[i] = -1;
+            fileNames[i][0] = '\0';
+            if (strlen(files[i]) >= MAX_FILE_NAME_SIZE)
+                fprintf(stderr, "File path is too long!\n");
+            else if (stat(files[i], &fileStat) != 0)
+                perror("stat error");
+            else
+            {
+                strcpy(fileNames[i], files[i]);
+                fileSizes[i] = fileStat.st_size;
+            }
+        }
+    }
+    MPI_Bcast(fileNames, nFiles * MAX_FILE_NAME_SIZE, MPI_CHAR, 0, MPI_COMM_WORLD);
+    MPI_Bcast(fileSizes, nFiles, MPI_LONG_LONG, 0, MPI_COMM_WORLD);
+    for (int i = 0; i < nFiles; i++)
+        if (fileSizes[i] < 0)
+            return FAILURE;
+
+    // every rank counts its range of each file, the counts of a file are summed at rank 0
+    int status = SUCCESS;
+    Result results[nFiles];
+    for (int i = 0; i < nFiles; i++)
+    {
+        Result result;
+        if (fr_countRange(fileNames[i], fileSizes[i], rank, nProc, result) == FAILURE)
+            status = FAILURE;
+        MPI_Reduce(result, results[i], 3, MPI_UINT32_T, MPI_SUM, 0, MPI_COMM_WORLD);
+    }
+
+    // FAILURE is lower than SUCCESS
+    int globalStatus;
+    MPI_Allreduce(&status, &globalStatus, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+
+    if (rank == 0)
+    {
+        // Determine executing time
+        clock_gettime(CLOCK_MONOTONIC, &endTime);
+        printf("\nElapsed time = %.6f s\n", (endTime.tv_sec - startTime.tv_sec) / 1.0 + (endTime.tv_nsec - startTime.tv_nsec) / 1000000000.0);
+
+        if (globalStatus == SUCCESS)
+            printResults(nFiles, fileNames, results);
+        else
+            fprintf(stderr, "Unable to get results something went wrong while counting the ranges\n");
+    }
+    return globalStatus;
+}
+
+void printResults(int nFiles, char fileNames[nFiles][MAX_FILE_NAME_SIZE], Result results[nFiles])
+{
+    for (int i = 0; i < nFiles; i++)
+    {
+        fprintf(stdout,
+                "\nFile name: %s\n"
+                "Total number of words = %d\n"
+                "N. of words beginning with a vowel = %d\n"
+                "N. of words ending with a consonant = %d\n",
+                fileNames[i], results[i][2], results[i][1], results[i][0]);
+    }
 }
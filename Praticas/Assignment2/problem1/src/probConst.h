@@ -18,10 +18,27 @@
 /** \brief maximum file path size */
 #define MAX_FILE_NAME_SIZE 50       
 
-/** \brief size of worker's data chuck buffer, last 2 bytes of the chunk specifies the amount of data sent */
-#define DATA_BUFFER_SIZE ((2 << 12) + 2) 
+/** \brief size of worker's data chuck buffer per thread of the worker, only the bytes used are sent */
+#ifndef DATA_BUFFER_SIZE
+#define DATA_BUFFER_SIZE (2 << 12)
+#endif
 
 /** \brief maximum size of fifo */
 #define FIFO_MAX_SIZE 20
 
+/** \brief number of chunks a proxy keeps sent to its worker, each one on its own tag */
+#define CHUNKS_IN_FLIGHT 4
+
+/** \brief tag of the empty message that ends a worker, after the ones of the chunks */
+#define TERMINATION_TAG CHUNKS_IN_FLIGHT
+
+/** \brief size of the buffer a rank reads its range of a file with, without dispatcher */
+#define RANGE_BUFFER_SIZE (1 << 20)
+
+/** \brief maximum number of threads counting in a rank */
+#define MAX_THREADS_PER_RANK 64
+
+/** \brief minimum size of the piece of a chunk counted by a thread of a rank */
+#define MIN_PIECE_SIZE (1 << 12)
+
 #endif /* PROB_CONST_H_ */
\ No newline at end of file
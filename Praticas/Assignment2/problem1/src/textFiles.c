@@ -90,7 +90,7 @@ int tf_close()
     return SUCCESS;
 }
 
-int tf_readChunk(uint8_t data[DATA_BUFFER_SIZE], FileHandler *fileHandler, bool *moreWork)
+int tf_readChunk(uint8_t *data, uint32_t capacity, uint32_t *dataSize, FileHandler *fileHandler, bool *moreWork)
 {
     bool moreWorkToDo = true;
     size_t size = 0;
@@ -102,7 +102,7 @@ int tf_readChunk(uint8_t data[DATA_BUFFER_SIZE], FileHandler *fileHandler, bool
         FILE *file = handlers[fileIdx].ptrFile;
         
         //Get data from file
-        if (( size = fread(data, sizeof(char), DATA_BUFFER_SIZE - 2, file) ) < DATA_BUFFER_SIZE - 2)
+        if (( size = fread(data, sizeof(char), capacity, file) ) < capacity)
         {
             if (ferror(file) != 0)
             {
@@ -114,7 +114,7 @@ int tf_readChunk(uint8_t data[DATA_BUFFER_SIZE], FileHandler *fileHandler, bool
             fileIdx++;
         }
 
-        bool foundDelimiter = false;
+        bool foundDelimiter = (size == 0);
         unsigned int goBackN = 0;
         
         //look for last delimiter character in buffer
@@ -147,9 +147,7 @@ int tf_readChunk(uint8_t data[DATA_BUFFER_SIZE], FileHandler *fileHandler, bool
     else
         moreWorkToDo = false;
 
-    //store size in dataBuffer
-    data[DATA_BUFFER_SIZE - 2] = (uint8_t) (size & 0x00FF);
-    data[DATA_BUFFER_SIZE - 1] = (uint8_t) ((size >> 8) & 0x00FF);
+    *dataSize = (uint32_t) size;
 
     *moreWork = moreWorkToDo;
     return SUCCESS;
@@ -61,24 +61,20 @@ int tf_close();
 
 /** \brief retrieves a new chunk of data.
  *  
- *  The size of the chunk of data is always less or equal then DATA_BUFFER_SIZE - 2. If there's no more text to process
- *  no chunk of data is retrieved and this function returns false, the thread might end is execution. The size of the chunk
- *  is store in the last 2 bytes of the array. 
- * 
- *  data[DATA_BUFFER_SIZE - 1] is the MSB.
- * 
- *  data[DATA_BUFFER_SIZE - 2] is the LSB.
+ *  The size of the chunk of data is always less or equal then capacity. If there's no more text to process
+ *  no chunk of data is retrieved and this function returns false, the thread might end is execution.
  * 
  *  \param[out] data Buffer containing the chunk of Data
+ *  \param capacity Size of the buffer
+ *  \param[out] dataSize Number of bytes of the chunk
  *  \param[out] fileHandler Target processing file handler
  *  \param[out] moreWork True if there is more dataChunks. False, otherwise.
  *
  *  \returns FAILURE If an error occurs, otherwise SUCCESS
  *  \sa FAILURE
  *  \sa SUCCESS 
- *  \sa DATA_BUFFER_SIZE
  */
-int tf_readChunk(uint8_t data[DATA_BUFFER_SIZE], FileHandler *fileHandler, bool* moreWork);
+int tf_readChunk(uint8_t *data, uint32_t capacity, uint32_t *dataSize, FileHandler *fileHandler, bool* moreWork);
 
 /** \brief Registers the results of a file's chunk of data
  *  
@@ -1,3 +1,5 @@
+#include <stdlib.h>
+#include <string.h>
 #include "utf8.h"
 
 /**
@@ -78,6 +80,87 @@ const static unsigned int apostrophe = 0x27;
 #define ASCII_LAST_LOWER_CASE_LETTER 0x7A
 
 
+/** \brief Number of second level classification blocks, block 0 is reserved for unknown sequences */
+#define CHAR_TYPE_BLOCKS 8
+
+/** \brief Character type of every single byte value (ASCII and invalid lone bytes) */
+static unsigned char singleByteTypes[256];
+
+/** \brief Second level block index of every 2 bytes lead byte (0xC0 - 0xDF) */
+static unsigned char twoBytesBlock[32];
+
+/** \brief Second level block index of every 3 bytes (lead byte 0xE0 - 0xEF, first continuation byte) pair */
+static unsigned char threeBytesBlock[16][64];
+
+/** \brief Character types indexed by block and by the last continuation byte of the sequence */
+static unsigned char charTypeBlocks[CHAR_TYPE_BLOCKS][64];
+
+/** \brief Number of second level blocks in use */
+static unsigned int usedBlocks;
+
+/** \brief Gets (allocating if needed) the second level block referenced by a first level entry
+ *
+ *  \param blockIdx first level entry
+ *
+ *  \returns block index
+ */
+static unsigned char getBlock(unsigned char *blockIdx)
+{
+    if (*blockIdx == 0)
+    {
+        if (usedBlocks == CHAR_TYPE_BLOCKS)
+        {
+            fprintf(stderr, "Error not enough utf8 classification blocks\n");
+            exit(EXIT_FAILURE);
+        }
+        *blockIdx = usedBlocks++;
+    }
+    return *blockIdx;
+}
+
+/** \brief Registers the character type of an utf8 character in the classification tables
+ *
+ *  \param utf8Char utf8 character
+ *  \param type character type
+ */
+static void setCharType(unsigned int utf8Char, enum CharacterType type)
+{
+    if (utf8Char <= 0xFF)
+        singleByteTypes[utf8Char] = type;
+    else if (utf8Char <= 0xFFFF)
+        charTypeBlocks[getBlock(&twoBytesBlock[(utf8Char >> 8) & 0x1F])][utf8Char & 0x3F] = type;
+    else if (utf8Char <= 0xFFFFFF)
+        charTypeBlocks[getBlock(&threeBytesBlock[(utf8Char >> 16) & 0x0F][(utf8Char >> 8) & 0x3F])][utf8Char & 0x3F] = type;
+}
+
+/** \brief Builds the classification tables at program startup
+ *
+ *  Types are registered from the lowest to the highest precedence, following the order in which
+ *  getUTF8CharTypeLinear checks them, so the tables always agree with the linear scan.
+ */
+__attribute__((constructor)) static void buildCharTypeTables(void)
+{
+    usedBlocks = 1;
+    memset(singleByteTypes, NOT_DEFINED, sizeof(singleByteTypes));
+    memset(charTypeBlocks, NOT_DEFINED, sizeof(charTypeBlocks));
+
+    setCharType(underscore, UNDERSCORE);
+    for (unsigned int c = 0x30; c <= 0x39; c++)
+        setCharType(c, DIGIT);
+    for (unsigned int c = ASCII_FIRST_UPPER_CASE_LETTER; c <= ASCII_LAST_UPPER_CASE_LETTER; c++)
+        setCharType(c, CONSOANT);
+    for (unsigned int c = ASCII_FIRST_LOWER_CASE_LETTER; c <= ASCII_LAST_LOWER_CASE_LETTER; c++)
+        setCharType(c, CONSOANT);
+    for (int i = 0; i < sizeof(specialConsoants) / sizeof(*specialConsoants); i++)
+        setCharType(specialConsoants[i], CONSOANT);
+    for (int i = 0; i < sizeof(vowels) / sizeof(*vowels); i++)
+        setCharType(vowels[i], VOWEL);
+    setCharType(apostrophe, APOSTROPHE);
+    for (int i = 0; i < sizeof(delimiters) / sizeof(*delimiters); i++)
+        setCharType(delimiters[i], DELIMITER);
+}
+
+
 int readUTF8Char(FILE *ptrFile, unsigned int *utf8Char)
 {
     unsigned char buffer[3];
@@ -128,6 +211,29 @@ int readUTF8Char(FILE *ptrFile, unsigned int *utf8Char)
 
 
 enum CharacterType getUTF8CharType(unsigned int utf8Char)
+{
+    if (utf8Char <= 0xFF)
+        return singleByteTypes[utf8Char];
+
+    if (utf8Char <= 0xFFFF) // 2 bytes character
+    {
+        if ((utf8Char & 0xE0C0) != 0xC080)
+            return NOT_DEFINED;
+        return charTypeBlocks[twoBytesBlock[(utf8Char >> 8) & 0x1F]][utf8Char & 0x3F];
+    }
+
+    if (utf8Char <= 0xFFFFFF) // 3 bytes character
+    {
+        if ((utf8Char & 0xF0C0C0) != 0xE08080)
+            return NOT_DEFINED;
+        return charTypeBlocks[threeBytesBlock[(utf8Char >> 16) & 0x0F][(utf8Char >> 8) & 0x3F]][utf8Char & 0x3F];
+    }
+
+    // no 4 bytes character is classified
+    return NOT_DEFINED;
+}
+
+enum CharacterType getUTF8CharTypeLinear(unsigned int utf8Char)
 {
     // Check if is a delimiter
     for (int i = 0; i < sizeof(delimiters) / sizeof(*delimiters); i++)
@@ -39,12 +39,26 @@ int readUTF8Char(FILE *ptrFile, unsigned int *utf8Char);
 
 /** \brief Determines the character type of an utf8 character 
  *  
+ *  The character is classified through lookup tables built at program startup: a 256 entries
+ *  table for single byte characters and a two level table for 2 and 3 bytes characters.
+ * 
  *  \param utf8Char utf8 character
  * 
  *  \returns corresponding enum character type
 */
 enum CharacterType getUTF8CharType(unsigned int utf8Char);
 
+/** \brief Determines the character type of an utf8 character by scanning the character lists
+ *  
+ *  Reference implementation of getUTF8CharType, kept to validate and benchmark the
+ *  table driven classification.
+ * 
+ *  \param utf8Char utf8 character
+ * 
+ *  \returns corresponding enum character type
+*/
+enum CharacterType getUTF8CharTypeLinear(unsigned int utf8Char);
+
 /** \brief Determines the size of an utf8 character through its first byte 
  *  
  *  The size of a utf8 character can range from 1 to 4 bytes. The first bit most
@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "workerPool.h"
+#include "utf8.h"
+#include "wordScanner.h"
+
+/**
+ *  \file workerPool.c
+ *
+ *  \brief Worker pool implementation
+ *
+ *  Threads of a rank sharing the counting of a chunk of data. A new chunk is announced by increasing
+ *  its generation, every thread counts the piece with its id, if any, and the last one to finish
+ *  wakes up the calling thread.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
+ */
+
+/** \brief Piece of a chunk counted by a single thread */
+struct sPiece
+{
+    const uint8_t *data;    /*!< First byte of the piece */
+    uint32_t size;          /*!< Size of the piece */
+    Result result;          /*!< Counting results of the piece */
+};
+typedef struct sPiece Piece;
+
+/** \brief number of threads counting a chunk, the calling one included */
+static unsigned int nThreads = 1;
+
+/** \brief threads of the pool */
+static pthread_t *threads;
+
+/** \brief ids of the threads of the pool, from 1 on */
+static unsigned int *threadIds;
+
+/** \brief pieces of the current chunk, indexed by thread id */
+static Piece *pieces;
+
+/** \brief number of pieces of the current chunk */
+static unsigned int nPieces;
+
+/** \brief increased for every chunk split among the pool */
+static unsigned int generation = 0;
+
+/** \brief pieces of the current chunk not counted yet by the pool */
+static unsigned int pending = 0;
+
+/** \brief set when the pool is closing */
+static bool closing = false;
+
+/** \brief locking flag which warrants mutual exclusion inside the monitor */
+static pthread_mutex_t accessCR = PTHREAD_MUTEX_INITIALIZER;
+
+/** \brief threads of the pool synchronization point when there is no chunk to count */
+static pthread_cond_t newChunk = PTHREAD_COND_INITIALIZER;
+
+/** \brief calling thread synchronization point while the pool counts its pieces */
+static pthread_cond_t piecesDone = PTHREAD_COND_INITIALIZER;
+
+
+/** \brief Counts the words of a piece */
+static void countPiece(Piece *piece)
+{
+    scanChunk(piece->data, piece->size, &piece->result[2], &piece->result[1], &piece->result[0]);
+}
+
+/** \brief Finds the position right after the first delimiter at or after pos
+ *
+ *  If the position is in the middle of a character the search begins at the next one.
+ *
+ *  \returns position right after the delimiter, size if there is none
+ */
+static uint32_t nextDelimiterEnd(const uint8_t *data, uint32_t size, uint32_t pos)
+{
+    while (pos < size)
+    {
+        //skip continuation bytes of the current character
+        if ((data[pos] & 0xC0) == 0x80)
+        {
+            pos++;
+            continue;
+        }
+
+        unsigned int characterSize = getUTF8CharSize(data[pos]);
+        if (characterSize == 0)
+            characterSize = 1;
+        if (characterSize > size - pos)
+            return size;
+
+        unsigned int utf8Char = data[pos];
+        for (int i = 1; i < characterSize; i++)
+            utf8Char = (utf8Char << 8) | data[pos + i];
+
+        pos += characterSize;
+        if (getUTF8CharType(utf8Char) == DELIMITER)
+            return pos;
+    }
+    return size;
+}
+
+/** \brief Execution code of a thread of the pool */
+static void *codePoolThread(void *args)
+{
+    unsigned int id = *((unsigned int *)args);
+    unsigned int seenGeneration = 0;
+
+    while (true)
+    {
+        pthread_mutex_lock(&accessCR);
+        while (generation == seenGeneration && !closing)
+            pthread_cond_wait(&newChunk, &accessCR);
+        if (closing)
+        {
+            pthread_mutex_unlock(&accessCR);
+            break;
+        }
+        seenGeneration = generation;
+        bool hasPiece = id < nPieces;
+        pthread_mutex_unlock(&accessCR);
+
+        if (!hasPiece)
+            continue;
+
+        countPiece(&pieces[id]);
+
+        pthread_mutex_lock(&accessCR);
+        if (--pending == 0)
+            pthread_cond_signal(&piecesDone);
+        pthread_mutex_unlock(&accessCR);
+    }
+    return NULL;
+}
+
+int wp_initialize(unsigned int threadsPerRank)
+{
+    nThreads = threadsPerRank;
+    pieces = (Piece *) malloc(nThreads * sizeof(Piece));
+    threads = (pthread_t *) malloc(nThreads * sizeof(pthread_t));
+    threadIds = (unsigned int *) malloc(nThreads * sizeof(unsigned int));
+    if (pieces == NULL || threads == NULL || threadIds == NULL)
+    {
+        perror("malloc error");
+        return FAILURE;
+    }
+
+    for (unsigned int i = 1; i < nThreads; i++)
+    {
+        threadIds[i] = i;
+        if (pthread_create(&threads[i], NULL, codePoolThread, &threadIds[i]) != 0)
+        {
+            fprintf(stderr, "Error on creating pool thread\n");
+            nThreads = i;
+            wp_close();
+            return FAILURE;
+        }
+    }
+    return SUCCESS;
+}
+
+void wp_processChunk(const uint8_t *data, uint32_t size, Result result)
+{
+    // pieces of at least MIN_PIECE_SIZE bytes, the first one counted by the calling thread
+    unsigned int n = size / MIN_PIECE_SIZE;
+    n = (n < 1) ? 1 : (n > nThreads) ? nThreads : n;
+
+    uint32_t begin = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        uint32_t end = (i == n - 1) ? size : nextDelimiterEnd(data, size, (uint32_t) ((uint64_t) size * (i + 1) / n));
+        pieces[i].data = data + begin;
+        pieces[i].size = (end > begin) ? end - begin : 0;
+        begin = (end > begin) ? end : begin;
+    }
+
+    if (n > 1)
+    {
+        pthread_mutex_lock(&accessCR);
+        nPieces = n;
+        pending = n - 1;
+        generation++;
+        pthread_cond_broadcast(&newChunk);
+        pthread_mutex_unlock(&accessCR);
+    }
+
+    countPiece(&pieces[0]);
+
+    if (n > 1)
+    {
+        pthread_mutex_lock(&accessCR);
+        while (pending > 0)
+            pthread_cond_wait(&piecesDone, &accessCR);
+        pthread_mutex_unlock(&accessCR);
+    }
+
+    // reduction of the counts of the pieces
+    result[0] = result[1] = result[2] = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        result[0] += pieces[i].result[0];
+        result[1] += pieces[i].result[1];
+        result[2] += pieces[i].result[2];
+    }
+}
+
+void wp_close()
+{
+    pthread_mutex_lock(&accessCR);
+    closing = true;
+    pthread_cond_broadcast(&newChunk);
+    pthread_mutex_unlock(&accessCR);
+
+    for (unsigned int i = 1; i < nThreads; i++)
+        pthread_join(threads[i], NULL);
+
+    free(pieces);
+    free(threads);
+    free(threadIds);
+}
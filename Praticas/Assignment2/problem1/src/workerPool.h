@@ -0,0 +1,46 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <stdint.h>
+#include "probConst.h"
+#include "textFiles.h"
+
+/**
+ *  \file workerPool.h
+ *
+ *  \brief Worker pool header
+ *
+ *  Threads of a rank sharing the counting of a chunk of data. The chunk is split in pieces of about
+ *  the same size whose ends are moved to right after the next delimiter, the calling thread counts the
+ *  first piece and the threads of the pool the other ones. The counts of the pieces are summed before
+ *  returning, so a rank with a pool answers a chunk with a single result.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - May 2022
+ */
+
+/** \brief Worker pool initialization.
+ *
+ *  Starts the threads of the pool, it must be called before calling any other function.
+ *
+ *  \param nThreads number of threads counting a chunk, the calling one included
+ *
+ *  \returns FAILURE If an error occurs, otherwise SUCCESS
+ *  \sa FAILURE
+ *  \sa SUCCESS
+ */
+int wp_initialize(unsigned int nThreads);
+
+/** \brief Counts the words of a chunk of data with the threads of the pool
+ *
+ *  The chunk is expected to start outside of a word, i.e., at the beginning of the text or after a delimiter.
+ *
+ *  \param data chunk of data
+ *  \param size size of the chunk of data
+ *  \param[out] result counting results of the chunk
+ */
+void wp_processChunk(const uint8_t *data, uint32_t size, Result result);
+
+/** \brief Stops the threads of the pool */
+void wp_close();
+
+#endif /* WORKER_POOL_H */
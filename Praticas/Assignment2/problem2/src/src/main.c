@@ -251,6 +251,10 @@ void worker(int rank, int * status) {
     double result;
     int order;
 
+    // the matrices are received into the same buffer and computed in place, it grows with their order
+    Matrix * matrix = NULL;
+    unsigned int capacity = 0;
+
     while (true)
     {
         // get order of the matrix
@@ -263,20 +267,29 @@ void worker(int rank, int * status) {
 
         if(VERBOSE) printf("Rank %d received order %d\n", rank, order);
 
+        if(order > capacity) {
+            free_matrix(matrix);
+            if((matrix = alloc_matrix(order)) == NULL) {
+                printf("Rank %d could not allocate a matrix of order %d\n", rank, order);
+                MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
+            }
+            capacity = order;
+        }
+        matrix->order = order;
+
         // receive actual matrix
-        double numbers[order][order];
-        MPI_Recv( (void *) numbers, order*order, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        MPI_Recv( (void *) matrix->numbers, order*order, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
         
-        if(VERBOSE) printf("Rank %d received matrix starting with %f\n", rank, numbers[0][0]);
+        if(VERBOSE) printf("Rank %d received matrix starting with %f\n", rank, matrix->numbers[0]);
 
         // compute matrix
-        Matrix * matrix = init_matrix(order, numbers);
         result = compute_determinant(*matrix);
 
         // return result
         MPI_Send( (void *) &result, 1, MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
         if(VERBOSE) printf("Rank %d return determinant %f\n", rank, result);
     }
+    free_matrix(matrix);
     *status = EXIT_SUCCESS;
 }
 
@@ -303,17 +316,11 @@ void * proxyComputingThread(void * arg) {
 
         order = matrixHandler->matrix->order;
 
-        // populate numbers array
-        double numbers[order][order];
-        for(int j=0;j<order;j++)
-            for(int k=0;k<order;k++)
-                numbers[j][k] = matrixHandler->matrix->numbers[j][k];
-
         if(VERBOSE) printf("Rank 0: send order %d to process %d\n", order, processId);
         MPI_Send((void *) &order, 1, MPI_INT, processId, 0, MPI_COMM_WORLD);
 
         if(VERBOSE) printf("Rank 0: send matrix to process %d\n", processId);
-        MPI_Send((void *) numbers, order*order, MPI_DOUBLE, processId, 0, MPI_COMM_WORLD);
+        MPI_Send((void *) matrixHandler->matrix->numbers, order*order, MPI_DOUBLE, processId, 0, MPI_COMM_WORLD);
 
         MPI_Recv((void *) &result, 1, MPI_DOUBLE, processId, 0, MPI_COMM_WORLD, &mpi_status);
 
@@ -366,16 +373,12 @@ void * file_reader_thread_worker(void * arg) {
                 matrixHandler->fileIdx = fileIdx;
                 matrixHandler->matrixIdx = i;
 
-                matrixHandler->matrix = (Matrix*) malloc(sizeof(Matrix));
-
-                matrixHandler->matrix->numbers = (double **) malloc(sizeof(double*)*order);
-                matrixHandler->matrix->order = order;
-
-                for(int i=0;i<order;i++) {
-                    // read matrix from files
-                    matrixHandler->matrix->numbers[i] = (double*) malloc(sizeof(double)*order);
-                    fread(matrixHandler->matrix->numbers[i], sizeof(double), order, ptrFile);
+                // read matrix from files, all its rows at once
+                if((matrixHandler->matrix = alloc_matrix(order)) == NULL) {
+                    printf("Rank 0 could not allocate a matrix of order %u\n", order);
+                    MPI_Abort(MPI_COMM_WORLD, EXIT_FAILURE);
                 }
+                fread(matrixHandler->matrix->numbers, sizeof(double), (size_t) order * order, ptrFile);
 
                 putMatrix(threadId, matrixHandler);
             }
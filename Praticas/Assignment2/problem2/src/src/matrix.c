@@ -4,34 +4,34 @@
 
 #include "matrix.h"
 
-void free_matrix(Matrix * matrix) {
-    for(int i=0;i<matrix->order;i++) {
-        free(matrix->numbers[i]);
-    }
-    free(matrix->numbers);
-    free(matrix);
-}
+/** \brief space taken by the Matrix in front of its coefficients, keeps them aligned */
+#define MATRIX_HEADER_SIZE ((sizeof(Matrix) + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT)
 
 
-Matrix * init_matrix(int order, double numbers[order][order]) {
-    Matrix * matrix = (Matrix*) malloc(sizeof(Matrix));
+Matrix * alloc_matrix(unsigned int order) {
+    // aligned_alloc requires the size to be a multiple of the alignment
+    size_t size = MATRIX_HEADER_SIZE + (size_t) order * order * sizeof(double);
+    size = (size + MATRIX_ALIGNMENT - 1) / MATRIX_ALIGNMENT * MATRIX_ALIGNMENT;
 
-    matrix->numbers = (double **) malloc(sizeof(double*)*order);
-    matrix->order = order;
-
-    for(int i=0;i<order;i++) {
-        // read matrix from files
-        matrix->numbers[i] = (double*) malloc(sizeof(double)*order);
-        matrix->numbers[i] = numbers[i];
+    Matrix * matrix = (Matrix*) aligned_alloc(MATRIX_ALIGNMENT, size);
+    if(matrix == NULL) {
+        return NULL;
     }
+
+    matrix->order = order;
+    matrix->numbers = (double*) ((char*) matrix + MATRIX_HEADER_SIZE);
     return matrix;
 }
 
+void free_matrix(Matrix * matrix) {
+    free(matrix);
+}
+
 void print_matrix(Matrix * matrix) {
     for(int i=0; i<matrix->order; i++) {
         printf("%d\n", i);
         for(int j=0; j<matrix->order; j++) {
-            printf("%f  ", matrix->numbers[i][j]);
+            printf("%f  ", matrix->numbers[i * matrix->order + j]);
         }
         printf("\n");
     }
@@ -39,10 +39,12 @@ void print_matrix(Matrix * matrix) {
 
 void switch_row(Matrix matrix, int row1, int row2) {
     double aux;
+    double * a = matrix.numbers + (size_t) row1 * matrix.order;
+    double * b = matrix.numbers + (size_t) row2 * matrix.order;
     for(int i=0;i<matrix.order;i++) {
-        aux = matrix.numbers[row1][i];
-        matrix.numbers[row1][i] = matrix.numbers[row2][i];
-        matrix.numbers[row2][i] = aux;
+        aux = a[i];
+        a[i] = b[i];
+        b[i] = aux;
     }
 }
 
@@ -50,11 +52,15 @@ double compute_determinant(Matrix matrix) {
     int sign = 1;
     double ratio, determinant = 1;
     
-    for(int i=0;i<matrix.order;i++) {
+    unsigned int order = matrix.order;
+    
+    for(int i=0;i<order;i++) {
+        double * pivotRow = matrix.numbers + (size_t) i * order;
+
         // check if the row can be used, otherwise, switch that row
-        if(matrix.numbers[i][i] == 0) {
-            for(int j=i+1;j<matrix.order;j++) {
-                if(matrix.numbers[j][i] != 0) {
+        if(pivotRow[i] == 0) {
+            for(int j=i+1;j<order;j++) {
+                if(matrix.numbers[(size_t) j * order + i] != 0) {
                     switch_row(matrix, i, j);
                     sign = (sign == 1) ? -1: 1;
                     break;
@@ -62,13 +68,14 @@ double compute_determinant(Matrix matrix) {
             }                
         }
 
-        for(int j=i+1;j<matrix.order;j++) {
-            ratio = matrix.numbers[j][i]/matrix.numbers[i][i];
-            for(int k=0;k<matrix.order;k++) {
-                matrix.numbers[j][k] = matrix.numbers[j][k]-ratio*matrix.numbers[i][k];
+        for(int j=i+1;j<order;j++) {
+            double * row = matrix.numbers + (size_t) j * order;
+            ratio = row[i]/pivotRow[i];
+            for(int k=0;k<order;k++) {
+                row[k] = row[k]-ratio*pivotRow[k];
             }
         }
-        determinant *= matrix.numbers[i][i];
+        determinant *= pivotRow[i];
     }
 
     return determinant * sign;
@@ -7,26 +7,35 @@
  * 
  */
 
-/** \brief Represents the Matrix */
+/** \brief alignment of the matrix coefficients, a cache line */
+#define MATRIX_ALIGNMENT 64
+
+/** \brief Represents the Matrix
+ *
+ *  The coefficients are stored row after row in a single block aligned to MATRIX_ALIGNMENT,
+ *  the coefficient of row i and column j is numbers[i * order + j]. They are sent and received
+ *  as they are, with a single message.
+ */
 typedef struct sMatrix {
     unsigned int order;
-    double ** numbers;
+    double * numbers;
 } Matrix;
 
 
-/** \brief Constructs a matrix
+/** \brief Allocates a matrix
+ *  
+ *  The Matrix and its coefficients are allocated in a single aligned block.
  * 
  *  \param order order of the matrix
- *  \param numbers pointer to pointers of rows of a matrix
- *  \param[out] matrix the pointer of the matrix constructed
  * 
+ *  \returns pointer to the matrix, NULL if there is not enough memory
 */
-Matrix * init_matrix(int order, double numbers[order][order]);
+Matrix * alloc_matrix(unsigned int order);
 
 
-/** \brief Clean matrix memory
+/** \brief Frees a matrix allocated by alloc_matrix
  *  
- *  \param matrix the pointer of the matrix to clean
+ *  \param matrix pointer of the matrix to be freed
  * 
 */
 void free_matrix(Matrix * matrix);
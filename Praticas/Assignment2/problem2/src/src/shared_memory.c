@@ -53,11 +53,7 @@ void sm_registerResult(MatrixHandler * matrixHandler, double result) {
     fh.determinants[matrixHandler->matrixIdx] = result;
 
     // free matrix handler
-    for(int i=0;i<matrixHandler->matrix->order;i++) {
-        free(matrixHandler->matrix->numbers[i]);
-    }
-    free(matrixHandler->matrix->numbers);
-    free(matrixHandler->matrix);
+    free_matrix(matrixHandler->matrix);
     free(matrixHandler);
 }
 
@@ -0,0 +1,181 @@
+#!/bin/bash
+#
+# Determinant benchmark suite
+#
+# Generates datasets with genMatrices, for every kind of matrix, order and count of the grid, and runs
+# the determinant programs over them:
+#   pthread     - Assignment1/Problem2 (pthreads, gaussian elimination), for each number of threads
+#   pthreadLU   - Assignment1/Problem2 (pthreads, blocked LU), for each number of threads
+#   mpi         - Assignment2/problem2 (MPI), for each number of worker ranks
+#   sequential  - GeneralProblems/Problem2 (single thread, first matrix of the file only)
+#   cudaHost    - Assignment3 host reference (single thread), only when nvcc is found
+#   cudaRows    - Assignment3 GPU kernel by rows, only when nvcc is found
+#   cudaCols    - Assignment3 GPU kernel by columns, only when nvcc is found
+#
+# Every run is appended to results.csv with its time, its GFLOP/s (2/3 order^3 per matrix) and the
+# largest relative error of its determinants against the long double ones of genMatrices. Singular
+# matrices have a null reference, their error is taken relative to the product of the norms of the
+# rows. genMatrices writes the log10 of that product, it overflows a double for large orders, and the
+# errors are computed as log10 too. The programs print 4 significant digits, so errors below 5e-4
+# only mean a correct result.
+# summary.csv holds the mean time, the standard deviation and the mean GFLOP/s of every configuration.
+#
+# USAGE: ./bench.sh [-d "orders ..."] [-n "counts ..."] [-t "threads ..."] [-k "types ..."] [-p "programs ..."] [-r runs]
+#
+
+ORDERS="32 128 512"
+COUNTS="16 128"
+THREADS="1 2 4 8"
+TYPES="random illcond singular pivot"
+PROGRAMS="pthread pthreadLU mpi sequential cudaHost cudaRows cudaCols"
+RUNS=3
+
+while getopts "d:n:t:k:p:r:h" opt; do
+    case $opt in
+        d) ORDERS=$OPTARG ;;
+        n) COUNTS=$OPTARG ;;
+        t) THREADS=$OPTARG ;;
+        k) TYPES=$OPTARG ;;
+        p) PROGRAMS=$OPTARG ;;
+        r) RUNS=$OPTARG ;;
+        *) sed -n '2,23p' "$0"; exit 1 ;;
+    esac
+done
+
+cd "$(dirname "$0")"
+ROOT=../..
+mkdir -p bin data
+
+# build, programs that cannot be built are left out
+gcc genMatrices.c -Wall -O3 -lm -o bin/genMatrices || exit 1
+AVAILABLE=""
+gcc $ROOT/Assignment1/Problem2/*.c -Wall -O3 -lpthread -lm -o bin/pthread && AVAILABLE="pthread pthreadLU"
+gcc $ROOT/GeneralProblems/Problem2/main.c -O3 -o bin/sequential 2> /dev/null && AVAILABLE="$AVAILABLE sequential"
+if command -v mpicc > /dev/null; then
+    mpicc $ROOT/Assignment2/problem2/src/src/*.c -O3 -lpthread -lm -o bin/mpi && AVAILABLE="$AVAILABLE mpi"
+fi
+if command -v nvcc > /dev/null; then
+    nvcc -O2 -Wno-deprecated-gpu-targets $ROOT/Assignment3/matrixDeterminantRows.cu -o bin/cudaRows &&
+        nvcc -O2 -Wno-deprecated-gpu-targets $ROOT/Assignment3/matrixDeterminantCols.cu -o bin/cudaCols &&
+        AVAILABLE="$AVAILABLE cudaHost cudaRows cudaCols"
+fi
+
+# selected <program>
+selected() {
+    [[ " $PROGRAMS " == *" $1 "* && " $AVAILABLE " == *" $1 "* ]]
+}
+
+# determinants <program> <output file>, prints "index determinant" lines and then "time seconds"
+determinants() {
+    case $1 in
+        pthread|pthreadLU)
+            sed -n -e 's/^The determinant of matrix \([0-9]*\) is \(.*\)$/\1 \2/p' \
+                -e 's/^Elapsed time = \([0-9.]*\) s$/time \1/p' "$2" ;;
+        mpi)
+            sed -n -e 's/^Elapsed time = \([0-9.]*\) s$/time \1/p' \
+                -e 's/^The determinant of matrix \([0-9]*\) is \(.*\)$/\1 \2/p' "$2" | awk '$1 == "time" {print; next} {print $1 - 1, $2}' ;;
+        sequential)
+            sed -n 's/^Determinant: \(.*\)$/0 \1/p' "$2" ;;
+        cudaHost)
+            sed -e 's/\x1b\[[0-9;]*m//g' "$2" | sed -n -e 's/^The cpu kernel took \([0-9.e+-]*\) seconds.*$/time \1/p' \
+                -e 's/^[A-Za-z]*: Matrix *\([0-9]*\) - host \([^ \t]*\)[ \t]*gpu.*$/\1 \2/p' | awk '$1 == "time" {print; next} {print $1 - 1, $2}' ;;
+        cudaRows|cudaCols)
+            sed -e 's/\x1b\[[0-9;]*m//g' "$2" | sed -n -e 's/^.*>>> elapsed \([0-9.e+-]*\) sec$/time \1/p' \
+                -e 's/^[A-Za-z]*: Matrix *\([0-9]*\) - host [^ \t]*[ \t]*gpu \([^ \t]*\)$/\1 \2/p' | awk '$1 == "time" {print; next} {print $1 - 1, $2}' ;;
+    esac
+}
+
+# run <program> <type> <order> <count> <workers> <command ...>
+run() {
+    PROGRAM=$1; TYPE=$2; ORDER=$3; COUNT=$4; WORKERS=$5; shift 5
+    for ((r = 1; r <= RUNS; r++)); do
+        START=$(date +%s.%N)
+        "$@" > bin/output.txt 2> /dev/null
+        END=$(date +%s.%N)
+        LINE=$(determinants $PROGRAM bin/output.txt | awk -v ref=$REF -v order=$ORDER -v wall=$(awk "BEGIN {print $END - $START}") '
+            BEGIN { while ((getline line < ref) > 0) { split(line, f, " "); det[f[1]] = f[2]; logBound[f[1]] = f[3] } }
+            $1 == "time" { time = $2; next }
+            $1 in det {
+                # errors are kept as log10, relative to the bound they go below the smallest double
+                d = $2 - det[$1]; if (d < 0) d = -d
+                scale = det[$1]; if (scale < 0) scale = -scale
+                if ($2 !~ /^-?[0-9]/) nan = 1
+                else if (d > 0) {
+                    e = (scale > 0) ? log(d / scale) / log(10) : log(d) / log(10) - logBound[$1]
+                    if (!nonZero || e > error) error = e
+                    nonZero = 1
+                }
+                n++
+            }
+            END {
+                if (n == 0) exit 1
+                if (time == "") time = wall
+                if (nan) error = "nan"
+                else if (!nonZero) error = sprintf("%.3e", 0)
+                else {
+                    exponent = int(error); if (exponent > error) exponent--
+                    mantissa = 10 ^ (error - exponent); if (mantissa >= 9.9995) { mantissa /= 10; exponent++ }
+                    error = sprintf("%.3fe%+03d", mantissa, exponent)
+                }
+                printf "%.6f,%.3f,%s", time, n * 2 / 3 * order ^ 3 / time / 1e9, error
+            }')
+        if [ $? -ne 0 ]; then
+            echo "$PROGRAM on $DATA with $WORKERS workers failed" >&2
+            return
+        fi
+        echo "$PROGRAM,$TYPE,$ORDER,$COUNT,$WORKERS,$r,$LINE" >> results.csv
+        echo "$PROGRAM $TYPE order=$ORDER count=$COUNT workers=$WORKERS run=$r $LINE" >&2
+    done
+}
+
+echo "program,type,order,count,workers,run,seconds,gflops,max_rel_error" > results.csv
+
+for TYPE in $TYPES; do
+    for ORDER in $ORDERS; do
+        for COUNT in $COUNTS; do
+            # dataset, file names must fit the buffers of the programs
+            DATA=data/${TYPE:0:1}${ORDER}_$COUNT.bin
+            REF=data/${TYPE:0:1}${ORDER}_$COUNT.ref
+            if [ ! -f $DATA ] || [ ! -f $REF ]; then
+                echo "Generating $DATA" >&2
+                bin/genMatrices -o $DATA -n $COUNT -d $ORDER -t $TYPE -r $ORDER -e $REF || exit 1
+            fi
+
+            for T in $THREADS; do
+                selected pthread && run pthread $TYPE $ORDER $COUNT $T bin/pthread -w $T -f $DATA
+                selected pthreadLU && run pthreadLU $TYPE $ORDER $COUNT $T bin/pthread -k lu -w $T -f $DATA
+                selected mpi && run mpi $TYPE $ORDER $COUNT $T mpiexec --oversubscribe -n $((T + 1)) bin/mpi -f $DATA
+            done
+            # the sequential program keeps the matrix on the stack
+            selected sequential && run sequential $TYPE $ORDER $COUNT 1 bash -c 'ulimit -s unlimited; exec "$@"' - bin/sequential $DATA
+            # a GPU block holds a thread per row or column
+            if [ $ORDER -le 1024 ]; then
+                selected cudaHost && run cudaHost $TYPE $ORDER $COUNT 1 bin/cudaRows -f $DATA
+                selected cudaRows && run cudaRows $TYPE $ORDER $COUNT 1 bin/cudaRows -f $DATA
+                selected cudaCols && run cudaCols $TYPE $ORDER $COUNT 1 bin/cudaCols -f $DATA
+            fi
+        done
+    done
+done
+rm -f bin/output.txt
+
+# summary of the runs of every configuration, errors are compared by their exponents, they may be
+# below the smallest double
+awk -F, 'function log10Error(e,    p) { split(e, p, "e"); return (p[1] + 0 == 0) ? -1e9 : log(p[1]) / log(10) + p[2] }
+    NR > 1 {
+        key = $1 "," $2 "," $3 "," $4 "," $5
+        if (!(key in n)) { order[++keys] = key; error[key] = 0 }
+        n[key]++; sum[key] += $7; sq[key] += $7 * $7; flops[key] += $8
+        if ($9 == "nan" || error[key] == "nan") error[key] = "nan"; else if (log10Error($9) > log10Error(error[key])) error[key] = $9
+    }
+    END {
+        print "program,type,order,count,workers,runs,mean_s,stddev_s,gflops,max_rel_error"
+        for (i = 1; i <= keys; i++) {
+            k = order[i]
+            mean = sum[k] / n[k]
+            var = sq[k] / n[k] - mean * mean; if (var < 0) var = 0
+            printf "%s,%d,%.6f,%.6f,%.3f,%s\n", k, n[k], mean, sqrt(var), flops[k] / n[k], error[k]
+        }
+    }' results.csv > summary.csv
+
+cat summary.csv
@@ -0,0 +1,286 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+/**
+ *  \file genMatrices.c
+ *
+ *  \brief Determinant dataset generator
+ *
+ *  Writes a file of square matrices in the format read by the determinant programs: the number of
+ *  matrices and their order, both unsigned int, followed by the coefficients of every matrix as
+ *  doubles, row by row. The kind of matrices is chosen from the command line:
+ *     \li random, coefficients uniform in [-s, s]
+ *     \li illcond, random with the last row a copy of the first one disturbed by 10^-c
+ *     \li singular, random with a row copied over another one
+ *     \li pivot, rows of an upper triangular matrix shuffled, every pivot of the gaussian elimination
+ *         is found by a row switch.
+ *
+ *  The coefficients are scaled by s = sqrt(3e / order), so that the determinant of a random matrix
+ *  stays around sqrt(order! * (s^2 / 3)^order), close to 1 for any order.
+ *
+ *  With -e the determinants are computed in long double, with partial pivoting, and written to a
+ *  reference file, one line per matrix with its index, its determinant and the log10 of the product of
+ *  the norms of its rows, the Hadamard bound of the determinant. The bound itself overflows a double
+ *  for large orders. The same seed always gives the same matrices.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - June 2022
+ */
+
+/** \brief Kind of matrices */
+enum MatrixType
+{
+    RANDOM,
+    ILL_CONDITIONED,
+    SINGULAR,
+    PIVOT
+};
+
+/** \brief Names of the kinds of matrices, as given in the command line */
+static const char *typeNames[] = {"random", "illcond", "singular", "pivot"};
+
+/** \brief Generation parameters */
+struct sParams
+{
+    unsigned int count;         /*!< Number of matrices */
+    unsigned int order;         /*!< Order of the matrices */
+    enum MatrixType type;       /*!< Kind of matrices */
+    unsigned int condition;     /*!< Disturbance exponent of the ill-conditioned matrices */
+    unsigned long long seed;    /*!< Random generator seed */
+};
+typedef struct sParams Params;
+
+/** \brief xorshift64* random generator state */
+static uint64_t rngState;
+
+/** \brief Next pseudo random number */
+static inline uint64_t nextRandom()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+/** \brief Pseudo random number in [0, n[ */
+static inline unsigned int randomBelow(unsigned int n)
+{
+    return (unsigned int) ((nextRandom() >> 32) % n);
+}
+
+/** \brief Pseudo random double in [-1, 1[ */
+static inline double randomUnit()
+{
+    return (double) (nextRandom() >> 11) / (double) (1ULL << 52) - 1;
+}
+
+/** \brief Fills a matrix of the given kind
+ *
+ *  \param params generation parameters
+ *  \param[out] m order * order coefficients
+ */
+static void generate(const Params *params, double *m)
+{
+    unsigned int n = params->order;
+    double scale = sqrt(3 * exp(1) / n);
+
+    if (params->type == PIVOT)
+    {
+        // upper triangle, the diagonal away from zero, rows shuffled by Fisher-Yates
+        unsigned int rows[n];
+        for (unsigned int i = 0; i < n; i++)
+            rows[i] = i;
+        for (unsigned int i = n - 1; i > 0; i--)
+        {
+            unsigned int j = randomBelow(i + 1);
+            unsigned int tmp = rows[i];
+            rows[i] = rows[j];
+            rows[j] = tmp;
+        }
+        for (unsigned int i = 0; i < n; i++)
+        {
+            double *row = m + (size_t) rows[i] * n;
+            for (unsigned int j = 0; j < n; j++)
+                row[j] = (j < i) ? 0 : randomUnit();
+            row[i] = (row[i] < 0) ? row[i] / 2 - 0.5 : row[i] / 2 + 0.5;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < (size_t) n * n; i++)
+        m[i] = randomUnit() * scale;
+    if (n < 2)
+        return;
+
+    if (params->type == ILL_CONDITIONED)
+    {
+        double disturbance = pow(10, -(double) params->condition);
+        double *last = m + (size_t) (n - 1) * n;
+        for (unsigned int j = 0; j < n; j++)
+            last[j] = m[j] + randomUnit() * scale * disturbance;
+    }
+    else if (params->type == SINGULAR)
+    {
+        unsigned int from = randomBelow(n);
+        unsigned int to = (from + 1 + randomBelow(n - 1)) % n;
+        memcpy(m + (size_t) to * n, m + (size_t) from * n, sizeof(double) * n);
+    }
+}
+
+/** \brief Long double determinant with partial pivoting
+ *
+ *  \param m order * order coefficients, left untouched
+ *  \param n order
+ *  \param a order * order scratch coefficients
+ *  \param[out] logBound log10 of the product of the norms of the rows
+ *
+ *  \returns determinant
+ */
+static long double reference(const double *m, unsigned int n, long double *a, long double *logBound)
+{
+    *logBound = 0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        long double norm = 0;
+        for (unsigned int j = 0; j < n; j++)
+        {
+            a[(size_t) i * n + j] = m[(size_t) i * n + j];
+            norm += (long double) m[(size_t) i * n + j] * m[(size_t) i * n + j];
+        }
+        *logBound += log10l(norm) / 2;
+    }
+
+    long double determinant = 1;
+    for (unsigned int k = 0; k < n; k++)
+    {
+        unsigned int pivot = k;
+        for (unsigned int i = k + 1; i < n; i++)
+            if (fabsl(a[(size_t) i * n + k]) > fabsl(a[(size_t) pivot * n + k]))
+                pivot = i;
+        if (a[(size_t) pivot * n + k] == 0)
+            return 0;
+        if (pivot != k)
+        {
+            for (unsigned int j = k; j < n; j++)
+            {
+                long double tmp = a[(size_t) k * n + j];
+                a[(size_t) k * n + j] = a[(size_t) pivot * n + j];
+                a[(size_t) pivot * n + j] = tmp;
+            }
+            determinant = -determinant;
+        }
+
+        long double *pivotRow = a + (size_t) k * n;
+        determinant *= pivotRow[k];
+        for (unsigned int i = k + 1; i < n; i++)
+        {
+            long double *row = a + (size_t) i * n;
+            long double ratio = row[k] / pivotRow[k];
+            for (unsigned int j = k + 1; j < n; j++)
+                row[j] -= ratio * pivotRow[j];
+        }
+    }
+    return determinant;
+}
+
+/** \brief Prints the command line usage */
+static void printUsage()
+{
+    fprintf(stderr, "USAGE: ./genMatrices -o file -n count -d order [-t type] [-c exponent] [-r seed] [-e referenceFile]\n"
+                    "  -o   output file\n"
+                    "  -n   number of matrices\n"
+                    "  -d   order of the matrices\n"
+                    "  -t   random, illcond, singular or pivot (default: random)\n"
+                    "  -c   the ill-conditioned row is disturbed by 10^-exponent (default: 10)\n"
+                    "  -r   random seed (default: 1)\n"
+                    "  -e   file of the long double determinants\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Params params = {0, 0, RANDOM, 10, 1};
+    char *fileName = NULL, *referenceName = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "o:n:d:t:c:r:e:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 'o': fileName = optarg; break;
+        case 'n': params.count = atoi(optarg); break;
+        case 'd': params.order = atoi(optarg); break;
+        case 't':
+            params.type = sizeof(typeNames) / sizeof(*typeNames);
+            for (unsigned int i = 0; i < sizeof(typeNames) / sizeof(*typeNames); i++)
+                if (strcmp(optarg, typeNames[i]) == 0)
+                    params.type = i;
+            if (params.type == sizeof(typeNames) / sizeof(*typeNames))
+            {
+                fprintf(stderr, "Invalid type: %s\n", optarg);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'c': params.condition = atoi(optarg); break;
+        case 'r': params.seed = strtoull(optarg, NULL, 10); break;
+        case 'e': referenceName = optarg; break;
+        case 'h': printUsage(); return EXIT_SUCCESS;
+        default: printUsage(); return EXIT_FAILURE;
+        }
+    }
+
+    if (fileName == NULL || params.count == 0 || params.order == 0)
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    FILE *out, *ref = NULL;
+    if ((out = fopen(fileName, "wb")) == NULL || (referenceName != NULL && (ref = fopen(referenceName, "w")) == NULL))
+    {
+        perror("fopen error");
+        return EXIT_FAILURE;
+    }
+
+    size_t size = (size_t) params.order * params.order;
+    double *m = (double *) malloc(sizeof(double) * size);
+    long double *a = (ref != NULL) ? (long double *) malloc(sizeof(long double) * size) : NULL;
+    if (m == NULL || (ref != NULL && a == NULL))
+    {
+        perror("malloc error");
+        return EXIT_FAILURE;
+    }
+
+    rngState = params.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    fwrite(&params.count, sizeof(unsigned int), 1, out);
+    fwrite(&params.order, sizeof(unsigned int), 1, out);
+    for (unsigned int i = 0; i < params.count; i++)
+    {
+        generate(&params, m);
+        if (fwrite(m, sizeof(double), size, out) != size)
+        {
+            perror("fwrite error");
+            return EXIT_FAILURE;
+        }
+        if (ref != NULL)
+        {
+            long double logBound;
+            long double determinant = reference(m, params.order, a, &logBound);
+            fprintf(ref, "%u %.20Le %.6Lf\n", i, determinant, logBound);
+        }
+    }
+
+    free(m);
+    free(a);
+    if (ref != NULL)
+        fclose(ref);
+    if (fclose(out) != 0)
+    {
+        perror("fclose error");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
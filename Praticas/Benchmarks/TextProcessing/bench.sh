@@ -0,0 +1,119 @@
+#!/bin/bash
+#
+# Text processing benchmark suite
+#
+# Generates a Portuguese-like corpus with genCorpus and runs the word counters over it:
+#   countWords  - Assignment1/Problem1 (pthreads), for each number of threads
+#   sequential  - GeneralProblems/Problem1 (single thread)
+#   mpi         - Assignment2/problem1 (MPI), for each number of worker ranks
+#   mpiRanges   - Assignment2/problem1 (MPI, -r), every rank reads its own ranges, for each number of ranks
+#   mpiHybrid   - Assignment2/problem1 (MPI, -t), a single worker rank, for each number of threads
+#
+# Every run is appended to results.csv, summary.csv holds the mean time, the standard deviation,
+# the throughput and the scaling efficiency of every configuration.
+#
+# USAGE: ./bench.sh [-s corpusSize] [-f nFiles] [-t "threads ..."] [-n "ranks ..."] [-r runs] [-- genCorpus options]
+#
+
+SIZE=1G
+FILES=4
+THREADS="1 2 4 8"
+RANKS="1 2 4 8"
+RUNS=5
+
+while getopts "s:f:t:n:r:h" opt; do
+    case $opt in
+        s) SIZE=$OPTARG ;;
+        f) FILES=$OPTARG ;;
+        t) THREADS=$OPTARG ;;
+        n) RANKS=$OPTARG ;;
+        r) RUNS=$OPTARG ;;
+        *) sed -n '2,15p' "$0"; exit 1 ;;
+    esac
+done
+shift $((OPTIND - 1))
+GEN_OPTIONS="$@"
+
+cd "$(dirname "$0")"
+ROOT=../..
+mkdir -p bin corpus
+
+# build
+gcc genCorpus.c -Wall -O3 -o bin/genCorpus || exit 1
+gcc $ROOT/Assignment1/Problem1/src/countWords.c $ROOT/Assignment1/Problem1/src/sharedMemory.c $ROOT/Assignment1/Problem1/src/utf8.c \
+    $ROOT/Assignment1/Problem1/src/wordScanner.c $ROOT/Assignment1/Problem1/src/prefetchReader.c -lpthread -Wall -O3 -o bin/countWords || exit 1
+gcc $ROOT/GeneralProblems/Problem1/main.c -O3 -o bin/sequential 2> /dev/null || exit 1
+HAVE_MPI=0
+if command -v mpicc > /dev/null; then
+    mpicc $ROOT/Assignment2/problem1/src/main.c $ROOT/Assignment2/problem1/src/fifo.c $ROOT/Assignment2/problem1/src/textFiles.c $ROOT/Assignment2/problem1/src/fileRanges.c $ROOT/Assignment2/problem1/src/workerPool.c \
+        $ROOT/Assignment2/problem1/src/utf8.c $ROOT/Assignment2/problem1/src/wordScanner.c -O3 -o bin/mpiCountWords -lpthread && HAVE_MPI=1
+fi
+
+# corpus, file names must fit MAX_FILE_NAME_SIZE
+CORPUS=()
+BYTES=0
+for ((i = 0; i < FILES; i++)); do
+    FILE=corpus/c$i.txt
+    FILE_SIZE=$(numfmt --from=iec $SIZE)
+    FILE_SIZE=$((FILE_SIZE / FILES))
+    if [ ! -f $FILE ] || [ $(stat -c %s $FILE) -lt $FILE_SIZE ]; then
+        echo "Generating $FILE ($FILE_SIZE bytes)" >&2
+        bin/genCorpus -s $FILE_SIZE -r $((i + 1)) -o $FILE $GEN_OPTIONS || exit 1
+    fi
+    CORPUS+=($FILE)
+    BYTES=$((BYTES + $(stat -c %s $FILE)))
+done
+
+# run <program> <workers> <command ...>
+run() {
+    PROGRAM=$1; WORKERS=$2; shift 2
+    for ((r = 1; r <= RUNS; r++)); do
+        SECONDS_=$("$@" 2> /dev/null | sed -n 's/^Elapsed time = \([0-9.]*\) s$/\1/p' | tail -1)
+        if [ -z "$SECONDS_" ]; then
+            echo "$PROGRAM with $WORKERS workers failed" >&2
+            return
+        fi
+        echo "$PROGRAM,$WORKERS,$r,$BYTES,$SECONDS_" >> results.csv
+        echo "$PROGRAM workers=$WORKERS run=$r time=$SECONDS_ s" >&2
+    done
+}
+
+echo "program,workers,run,bytes,seconds" > results.csv
+
+for T in $THREADS; do
+    run countWords $T bin/countWords -t $T "${CORPUS[@]}"
+done
+
+run sequential 1 bin/sequential "${CORPUS[@]}"
+
+if [ $HAVE_MPI -eq 1 ]; then
+    for N in $RANKS; do
+        run mpi $N mpiexec --oversubscribe -n $((N + 1)) bin/mpiCountWords "${CORPUS[@]}"
+        run mpiRanges $N mpiexec --oversubscribe -n $N bin/mpiCountWords -r "${CORPUS[@]}"
+    done
+    for T in $THREADS; do
+        run mpiHybrid $T mpiexec --oversubscribe -n 2 bin/mpiCountWords -t $T "${CORPUS[@]}"
+    done
+fi
+
+# summary, efficiency is relative to the configuration with fewest workers of each program
+awk -F, 'NR > 1 {
+        key = $1 "," $2
+        if (!(key in n)) order[++keys] = key
+        n[key]++; sum[key] += $5; sq[key] += $5 * $5; bytes[key] = $4
+        if (!($1 in base) || $2 < baseWorkers[$1]) { base[$1] = key; baseWorkers[$1] = $2 }
+    }
+    END {
+        print "program,workers,runs,bytes,mean_s,stddev_s,cv,mb_per_s,speedup,efficiency"
+        for (i = 1; i <= keys; i++) {
+            k = order[i]; split(k, f, ",")
+            mean = sum[k] / n[k]
+            var = sq[k] / n[k] - mean * mean; if (var < 0) var = 0
+            b = base[f[1]]; baseMean = sum[b] / n[b]
+            speedup = baseMean / mean
+            printf "%s,%d,%.0f,%.6f,%.6f,%.4f,%.2f,%.3f,%.3f\n", k, n[k], bytes[k], mean, sqrt(var), sqrt(var) / mean,
+                   bytes[k] / 1048576 / mean, speedup, speedup * baseWorkers[f[1]] / f[2]
+        }
+    }' results.csv > summary.csv
+
+cat summary.csv
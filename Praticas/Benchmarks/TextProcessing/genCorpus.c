@@ -0,0 +1,253 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/**
+ *  \file genCorpus.c
+ *
+ *  \brief Portuguese-like UTF8 corpus generator
+ *
+ *  Writes a text of the requested size made of pseudo Portuguese words, built from consoant-vowel
+ *  syllables, separated by spaces and punctuation. The share of accented vowels, 'ç', em-dashes and
+ *  ellipses is controlled from the command line, so that the corpus can stress both the ASCII and
+ *  the multi-byte paths of the word counters. The same seed always gives the same text.
+ *
+ *  \author João Diogo Ferreira, João Tiago Rainho - June 2022
+ */
+
+/** \brief size of the output buffer */
+#define OUT_BUFFER_SIZE (1 << 20)
+
+/** \brief maximum number of syllables in a word */
+#define MAX_SYLLABLES 4
+
+/** \brief Plain vowels */
+static const char *vowels[] = {"a", "e", "i", "o", "u", "a", "e", "o"};
+
+/** \brief Accented vowels */
+static const char *accentedVowels[] = {"á", "à", "â", "ã", "é", "ê", "í", "ó", "ô", "õ", "ú", "ã", "é", "á"};
+
+/** \brief Plain consoants, repeated according to their frequency in Portuguese */
+static const char *consoants[] = {"s", "r", "n", "d", "m", "t", "c", "l", "p", "v", "g", "b", "f", "h", "q",
+                                  "z", "j", "x", "s", "r", "n", "d", "m", "t", "s", "c", "p", "d", "m"};
+
+/** \brief Capital letters beginning some words */
+static const char *capitals[] = {"A", "E", "O", "Á", "É", "Ó", "S", "C", "P", "D", "M", "Ç"};
+
+/** \brief Generation parameters */
+struct sParams
+{
+    unsigned long long size;    /*!< Size of the corpus in bytes */
+    unsigned int accents;       /*!< Percentage of accented vowels */
+    unsigned int cedillas;      /*!< Percentage of 'ç' among consoants */
+    unsigned int dashes;        /*!< Percentage of em-dashes among word separators */
+    unsigned int ellipses;      /*!< Percentage of ellipses among sentence endings */
+    unsigned long long seed;    /*!< Random generator seed */
+};
+typedef struct sParams Params;
+
+/** \brief xorshift64* random generator state */
+static uint64_t rngState;
+
+/** \brief Next pseudo random number */
+static inline uint64_t nextRandom()
+{
+    rngState ^= rngState >> 12;
+    rngState ^= rngState << 25;
+    rngState ^= rngState >> 27;
+    return rngState * 0x2545F4914F6CDD1DULL;
+}
+
+/** \brief Pseudo random number in [0, n[ */
+static inline unsigned int randomBelow(unsigned int n)
+{
+    return (unsigned int) ((nextRandom() >> 32) % n);
+}
+
+/** \brief True with the given percentage */
+static inline int chance(unsigned int percentage)
+{
+    return randomBelow(100) < percentage;
+}
+
+/** \brief Output buffer */
+static char outBuffer[OUT_BUFFER_SIZE];
+
+/** \brief Bytes in the output buffer */
+static size_t outSize;
+
+/** \brief Appends a string to the output buffer, flushing it when full */
+static void emit(const char *text, FILE *out)
+{
+    size_t length = strlen(text);
+    if (outSize + length > OUT_BUFFER_SIZE)
+    {
+        fwrite(outBuffer, 1, outSize, out);
+        outSize = 0;
+    }
+    memcpy(outBuffer + outSize, text, length);
+    outSize += length;
+}
+
+/** \brief Appends one vowel */
+static void emitVowel(const Params *params, FILE *out)
+{
+    if (chance(params->accents))
+        emit(accentedVowels[randomBelow(sizeof(accentedVowels) / sizeof(*accentedVowels))], out);
+    else
+        emit(vowels[randomBelow(sizeof(vowels) / sizeof(*vowels))], out);
+}
+
+/** \brief Appends one consoant */
+static void emitConsoant(const Params *params, FILE *out)
+{
+    if (chance(params->cedillas))
+        emit(chance(90) ? "ç" : "Ç", out);
+    else
+        emit(consoants[randomBelow(sizeof(consoants) / sizeof(*consoants))], out);
+}
+
+/** \brief Appends one word */
+static void emitWord(const Params *params, FILE *out)
+{
+    if (chance(3)) // numbers
+    {
+        char number[16];
+        snprintf(number, sizeof(number), "%u", randomBelow(10000));
+        emit(number, out);
+        return;
+    }
+
+    if (chance(5)) // capitalized word
+        emit(capitals[randomBelow(sizeof(capitals) / sizeof(*capitals))], out);
+    else if (chance(30)) // word beginning in vowel
+        emitVowel(params, out);
+
+    unsigned int nSyllables = 1 + randomBelow(MAX_SYLLABLES);
+    for (unsigned int i = 0; i < nSyllables; i++)
+    {
+        emitConsoant(params, out);
+        emitVowel(params, out);
+    }
+
+    if (chance(35)) // word ending in consoant
+        emitConsoant(params, out);
+
+    if (chance(2)) // merged words
+    {
+        emit(chance(50) ? "'" : "’", out);
+        emitWord(params, out);
+    }
+}
+
+/** \brief Parses a size with an optional K, M or G suffix */
+static unsigned long long parseSize(const char *text)
+{
+    char *end;
+    unsigned long long size = strtoull(text, &end, 10);
+    switch (*end)
+    {
+    case 'k': case 'K': return size << 10;
+    case 'm': case 'M': return size << 20;
+    case 'g': case 'G': return size << 30;
+    default: return size;
+    }
+}
+
+/** \brief Prints the command line usage */
+static void printUsage()
+{
+    fprintf(stderr, "USAGE: ./genCorpus -s size[K|M|G] [-o file] [-a accents%%] [-c cedillas%%] [-d dashes%%] [-e ellipses%%] [-r seed]\n"
+                    "  -s   size of the corpus\n"
+                    "  -o   output file (default: stdout)\n"
+                    "  -a   percentage of accented vowels (default: 8)\n"
+                    "  -c   percentage of 'ç' among consoants (default: 3)\n"
+                    "  -d   percentage of em-dashes among word separators (default: 1)\n"
+                    "  -e   percentage of ellipses among sentence endings (default: 5)\n"
+                    "  -r   random seed (default: 1)\n");
+}
+
+int main(int argc, char *argv[])
+{
+    Params params = {0, 8, 3, 1, 5, 1};
+    char *fileName = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "s:o:a:c:d:e:r:h")) != -1)
+    {
+        switch (opt)
+        {
+        case 's': params.size = parseSize(optarg); break;
+        case 'o': fileName = optarg; break;
+        case 'a': params.accents = atoi(optarg); break;
+        case 'c': params.cedillas = atoi(optarg); break;
+        case 'd': params.dashes = atoi(optarg); break;
+        case 'e': params.ellipses = atoi(optarg); break;
+        case 'r': params.seed = strtoull(optarg, NULL, 10); break;
+        case 'h': printUsage(); return EXIT_SUCCESS;
+        default: printUsage(); return EXIT_FAILURE;
+        }
+    }
+
+    if (params.size == 0)
+    {
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    FILE *out = stdout;
+    if (fileName != NULL && (out = fopen(fileName, "wb")) == NULL)
+    {
+        perror("fopen error");
+        return EXIT_FAILURE;
+    }
+
+    rngState = params.seed * 0x9E3779B97F4A7C15ULL + 1;
+
+    unsigned long long written = 0;
+    unsigned int wordsInSentence = 0;
+    while (written + outSize < params.size)
+    {
+        emitWord(&params, out);
+        wordsInSentence++;
+
+        if (wordsInSentence > 4 && chance(10)) // end of sentence
+        {
+            static const char *endings[] = {".", ".", ".", "?", "!"};
+            emit(chance(params.ellipses) ? "…" : endings[randomBelow(5)], out);
+            emit(chance(15) ? "\n" : " ", out);
+            wordsInSentence = 0;
+        }
+        else if (chance(params.dashes))
+            emit(chance(50) ? " — " : "—", out);
+        else
+        {
+            switch (randomBelow(40))
+            {
+            case 0: case 1: case 2: emit(", ", out); break;
+            case 3: emit("-", out); break;
+            case 4: emit(": ", out); break;
+            case 5: emit("; ", out); break;
+            case 6: emit(" “", out); emitWord(&params, out); emit("” ", out); break;
+            case 7: emit(" (", out); emitWord(&params, out); emit(") ", out); break;
+            default: emit(" ", out); break;
+            }
+        }
+
+        if (outSize > OUT_BUFFER_SIZE / 2)
+        {
+            written += outSize;
+            fwrite(outBuffer, 1, outSize, out);
+            outSize = 0;
+        }
+    }
+    emit("\n", out);
+    fwrite(outBuffer, 1, outSize, out);
+
+    if (out != stdout)
+        fclose(out);
+
+    return EXIT_SUCCESS;
+}